@@ -1,18 +1,37 @@
 #include "json.h"
 #include <cstdio>
 
-static void make_indent(char* dst, int depth)
+static void print_indent(int depth)
 {
-    int i = 0;
-    while (i < depth)
-        dst[i++] = '\t';
-    dst[i] = 0;
+    for (int i = 0; i < depth; ++i)
+        putchar('\t');
 }
 
-static void json_object_dump(const JSonObject& obj, int depth);
-static void json_array_dump(const JSonArray& array, int depth);
+static void print_string(JSonStringView str)
+{
+    putchar('"');
+    for (char ch : str) {
+        unsigned char c = (unsigned char)ch;
+        switch (c) {
+        case '"': printf("\\\""); break;
+        case '\\': printf("\\\\"); break;
+        case '\b': printf("\\b"); break;
+        case '\f': printf("\\f"); break;
+        case '\n': printf("\\n"); break;
+        case '\r': printf("\\r"); break;
+        case '\t': printf("\\t"); break;
+        default:
+            if (c < 0x20)
+                printf("\\u%04x", c);
+            else
+                putchar(c);
+            break;
+        }
+    }
+    putchar('"');
+}
 
-static void json_value_dump(const JSonValue& val, int depth)
+static void print_scalar(const JSonValue& val)
 {
     switch (val.type()) {
     case JSonValueType::Bool:
@@ -22,55 +41,90 @@ static void json_value_dump(const JSonValue& val, int depth)
         printf("%d", val.number());
         break;
     case JSonValueType::String:
-        printf("\"%s\"", val.string().c_str());
-        break;
-    case JSonValueType::Object:
-        json_object_dump(val.object(), depth);
-        break;
-    case JSonValueType::Array:
-        json_array_dump(val.array(), depth);
+        print_string(val.string());
         break;
     default:
         break;
     }
 }
 
-static void json_array_dump(const JSonArray& array, int depth)
+// An open object or array while dumping. Nesting is kept on an explicit
+// stack, so arbitrarily deep documents print without recursion.
+struct JSonDumpFrame {
+    const JSonObject* object;
+    const JSonArray* array;
+    JSonObject::const_iterator it;
+    size_t index;
+};
+
+static void json_tree_dump(const JSonObject& root, bool pretty)
 {
-    char indent[256];
-    make_indent(indent, depth);
+    std::vector<JSonDumpFrame> stack;
 
-    printf("[\n");
-    for (size_t i = 0; i < array.size(); ++i) {
-        printf("%s\t", indent);
-        json_value_dump(array[i], depth + 1);
-        if (i < array.size()-1)
-            printf(",");
-        printf("\n");
-    }
-    printf("%s]", indent);
-}
+    auto open = [&stack, pretty](const JSonObject* obj, const JSonArray* array) {
+        printf(obj ? (pretty ? "{\n" : "{") : (pretty ? "[\n" : "["));
+        JSonDumpFrame f;
+        f.object = obj;
+        f.array = array;
+        if (obj)
+            f.it = obj->begin();
+        f.index = 0;
+        stack.push_back(f);
+    };
 
-static void json_object_dump(const JSonObject& obj, int depth)
-{
-    char indent[256];
-    make_indent(indent, depth);
+    open(&root, nullptr);
+    while (!stack.empty()) {
+        JSonDumpFrame& f = stack.back();
+        int depth = (int)stack.size();
+        bool first = f.object ? f.it == f.object->begin() : f.index == 0;
+        bool done = f.object ? f.it == f.object->end() : f.index == f.array->size();
 
-    printf("{\n");
-    size_t n = obj.size();
-    size_t i = 0;
-    for (const auto& p : obj) {
-        printf("%s\t\"%s\": ", indent, p.first.c_str());
-        json_value_dump(p.second, depth + 1);
-        if (++i != n)
-            printf(",");
-        printf("\n");
+        if (!first) {
+            if (!done)
+                printf(",");
+            if (pretty)
+                printf("\n");
+        }
+
+        if (done) {
+            bool is_object = f.object != nullptr;
+            stack.pop_back();
+            if (pretty)
+                print_indent(depth - 1);
+            printf(is_object ? "}" : "]");
+            continue;
+        }
+
+        if (pretty)
+            print_indent(depth);
+
+        const JSonValue* v;
+        if (f.object) {
+            print_string(JSonStringView(f.it->first.c_str(), f.it->first.size()));
+            printf(pretty ? ": " : ":");
+            v = &f.it->second;
+            ++f.it;
+        } else {
+            v = &(*f.array)[f.index++];
+        }
+
+        if (v->type() == JSonValueType::Object)
+            open(&v->object(), nullptr);
+        else if (v->type() == JSonValueType::Array)
+            open(nullptr, &v->array());
+        else
+            print_scalar(*v);
     }
-    printf("%s}", indent);
 }
 
 void json_dump(const JSonObject& obj)
 {
-    json_object_dump(obj, 0);
+    json_tree_dump(obj, true);
+    printf("\n");
+}
+
+void json_dump_compact(const JSonObject& obj)
+{
+    json_tree_dump(obj, false);
     printf("\n");
 }
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <map>
+#include <new>
 
 enum class JSonValueType : uint8_t {
     Null,
@@ -19,142 +22,221 @@ using JSonString = std::string;
 using JSonObject = std::map<std::string, JSonValue>;
 using JSonArray = std::vector<JSonValue>;
 
-class JSonValue {
+// Read-only view of a string value, which may live inside the JSonValue
+// or on the heap. Always null terminated.
+class JSonStringView {
 public:
-    JSonValue()
-        : m_type{JSonValueType::Null}
+    JSonStringView(const char* data, size_t size)
+        : m_data{data}
+        , m_size{size}
     {}
-    JSonValue(const JSonValue& other)
-        : m_type{other.m_type}
-    {
-        switch (m_type) {
-        case JSonValueType::Bool:
-            m_bool = other.m_bool;
-            break;
-        case JSonValueType::Number:
-            m_number = other.m_number;
-            break;
-        case JSonValueType::String:
-            new (&m_string) auto(other.m_string);
-            break;
-        case JSonValueType::Object:
-            new (&m_object) auto(other.m_object);
-            break;
-        case JSonValueType::Array:
-            new (&m_array) auto(other.m_array);
-            break;
-        default:
-            break;
-        }
-    }    
-    JSonValue(JSonValue&& other)
-        : m_type{other.m_type}
-    {
-        switch (m_type) {
-        case JSonValueType::Bool:
-            m_bool = other.m_bool;
-            break;
-        case JSonValueType::Number:
-            m_number = other.m_number;
-            break;
+
+    const char* data() const { return m_data; }
+    const char* c_str() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const char* begin() const { return m_data; }
+    const char* end() const { return m_data + m_size; }
+
+    JSonString str() const { return JSonString(m_data, m_size); }
+
+private:
+    const char* m_data;
+    size_t m_size;
+};
+
+// 16 byte tagged value. The last byte holds the type in bits 0-2; for
+// strings of up to 14 bytes, bit 3 marks inline storage and bits 4-7 the
+// length, with the chars and a terminating null in the bytes before it.
+// Longer strings, objects and arrays are held through a pointer in the
+// first 8 bytes.
+class JSonValue {
+public:
+    JSonValue() {
+        set_tag(JSonValueType::Null);
+    }
+    JSonValue(const JSonValue& other) {
+        switch (other.type()) {
         case JSonValueType::String:
-            new (&m_string) auto(std::move(other.m_string));
-            other.m_string.~JSonString();
-            other.m_type = JSonValueType::Null;
+            if (other.is_inline())
+                memcpy(m_data, other.m_data, sizeof(m_data));
+            else
+                init_heap(JSonValueType::String, new JSonString(*other.heap_string()));
             break;
         case JSonValueType::Object:
-            new (&m_object) auto(std::move(other.m_object));
-            other.m_object.~JSonObject();
-            other.m_type = JSonValueType::Null;
+            init_heap(JSonValueType::Object, new JSonObject(*other.heap<JSonObject>()));
             break;
         case JSonValueType::Array:
-            new (&m_array) auto(std::move(other.m_array));
-            other.m_array.~JSonArray();
-            other.m_type = JSonValueType::Null;
+            init_heap(JSonValueType::Array, new JSonArray(*other.heap<JSonArray>()));
             break;
         default:
+            memcpy(m_data, other.m_data, sizeof(m_data));
             break;
         }
     }
-    JSonValue(bool val)
-        : m_type{JSonValueType::Bool}
-        , m_bool{val}
-    {}
-    JSonValue(int val)
-        : m_type{JSonValueType::Number}
-        , m_number{val}
-    {}
-    JSonValue(const char* val)
-        : m_type{JSonValueType::String}
-    {
-        new (&m_string) std::string(val);
+    JSonValue(JSonValue&& other) noexcept {
+        memcpy(m_data, other.m_data, sizeof(m_data));
+        other.set_tag(JSonValueType::Null);
     }
-    JSonValue(const std::string& val)
-        : m_type{JSonValueType::String}
-    {
-        new (&m_string) auto(val);
+    JSonValue(bool val) {
+        set_tag(JSonValueType::Bool);
+        m_data[0] = val;
     }
-    JSonValue(std::string&& val)
-        : m_type{JSonValueType::String}
-    {
-        new (&m_string) auto(std::move(val));
+    JSonValue(int val) {
+        set_tag(JSonValueType::Number);
+        memcpy(m_data, &val, sizeof(val));
+    }
+    JSonValue(const char* val) {
+        init_string(val, strlen(val));
+    }
+    JSonValue(const std::string& val) {
+        init_string(val.data(), val.size());
+    }
+    JSonValue(std::string&& val) {
+        if (val.size() <= max_inline)
+            init_string(val.data(), val.size());
+        else
+            init_heap(JSonValueType::String, new JSonString(std::move(val)));
     }
 
-    JSonValue(const JSonObject& val)
-        : m_type{JSonValueType::Object}
-    {
-        new (&m_object) auto(val);
+    JSonValue(const JSonObject& val) {
+        init_heap(JSonValueType::Object, new JSonObject(val));
     }
-    JSonValue(JSonObject&& val)
-        : m_type{JSonValueType::Object}
-    {
-        new (&m_object) auto(std::move(val));
+    JSonValue(JSonObject&& val) {
+        init_heap(JSonValueType::Object, new JSonObject(std::move(val)));
     }
-    JSonValue(const JSonArray& val)
-        : m_type{JSonValueType::Array}
-    {
-        new (&m_array) auto(val);
+    JSonValue(const JSonArray& val) {
+        init_heap(JSonValueType::Array, new JSonArray(val));
     }
-    JSonValue(JSonArray&& val)
-        : m_type{JSonValueType::Array}
-    {
-        new (&m_array) auto(std::move(val));
+    JSonValue(JSonArray&& val) {
+        init_heap(JSonValueType::Array, new JSonArray(std::move(val)));
     }
 
     ~JSonValue() {
-        switch (m_type) {
+        switch (type()) {
         case JSonValueType::Null:
         case JSonValueType::Bool:
         case JSonValueType::Number:
             break;
         case JSonValueType::String:
-            m_string.~JSonString();
+            if (!is_inline())
+                delete heap_string();
             break;
         case JSonValueType::Object:
-            m_object.~JSonObject();
-            break;
         case JSonValueType::Array:
-            m_array.~JSonArray();
+            destroy_tree();
             break;
         }
     }
 
-    JSonValueType type() const { return m_type; }
-    bool boolean() const { return m_bool; }
-    int number() const { return m_number; }
-    const JSonString& string() const { return m_string; }
-    const JSonObject& object() const { return m_object; }
-    const JSonArray& array() const { return m_array; }
+    JSonValue& operator=(const JSonValue& other) {
+        if (this != &other) {
+            JSonValue tmp(other);
+            this->~JSonValue();
+            new (this) JSonValue(std::move(tmp));
+        }
+        return *this;
+    }
+    // other may live inside this value, so take it out before destroying ours
+    JSonValue& operator=(JSonValue&& other) noexcept {
+        if (this != &other) {
+            JSonValue tmp(std::move(other));
+            this->~JSonValue();
+            new (this) JSonValue(std::move(tmp));
+        }
+        return *this;
+    }
+
+    JSonValueType type() const { return (JSonValueType)(m_data[tag_byte] & type_mask); }
+    bool boolean() const { return m_data[0] != 0; }
+    int number() const {
+        int n;
+        memcpy(&n, m_data, sizeof(n));
+        return n;
+    }
+    JSonStringView string() const {
+        if (is_inline())
+            return JSonStringView((const char*)m_data, m_data[tag_byte] >> len_shift);
+
+        const JSonString* s = heap_string();
+        return JSonStringView(s->c_str(), s->size());
+    }
+    const JSonObject& object() const { return *heap<JSonObject>(); }
+    const JSonArray& array() const { return *heap<JSonArray>(); }
 
 private:
-    JSonValueType m_type;
-    union {
-        bool m_bool;
-        int m_number;
-        JSonString m_string;
-        JSonObject m_object;
-        JSonArray m_array;
-    };    
+    static const size_t tag_byte = 15;
+    static const uint8_t type_mask = 0x07;
+    static const uint8_t inline_flag = 0x08;
+    static const int len_shift = 4;
+    static const size_t max_inline = 14;
+
+    void set_tag(JSonValueType t, uint8_t bits = 0) {
+        m_data[tag_byte] = (uint8_t)t | bits;
+    }
+    bool is_inline() const { return (m_data[tag_byte] & inline_flag) != 0; }
+
+    void init_string(const char* s, size_t len) {
+        if (len <= max_inline) {
+            memcpy(m_data, s, len);
+            m_data[len] = 0;
+            set_tag(JSonValueType::String, inline_flag | (uint8_t)(len << len_shift));
+        } else {
+            init_heap(JSonValueType::String, new JSonString(s, len));
+        }
+    }
+
+    void init_heap(JSonValueType t, void* p) {
+        memcpy(m_data, &p, sizeof(p));
+        set_tag(t);
+    }
+
+    template <typename T>
+    T* heap() const {
+        T* p;
+        memcpy(&p, m_data, sizeof(p));
+        return p;
+    }
+    JSonString* heap_string() const { return heap<JSonString>(); }
+
+    // Nested containers are moved onto a work list before their parent is
+    // deleted, so teardown does not recurse once per nesting level.
+    void destroy_tree() {
+        std::vector<JSonValue> work;
+        release(work);
+        while (!work.empty()) {
+            JSonValue v(std::move(work.back()));
+            work.pop_back();
+            v.release(work);
+        }
+    }
+    // deletes this container, moving nested containers to work first
+    void release(std::vector<JSonValue>& work) {
+        if (type() == JSonValueType::Object) {
+            JSonObject* obj = heap<JSonObject>();
+            for (auto& p : *obj) {
+                if (p.second.is_container())
+                    work.emplace_back(std::move(p.second));
+            }
+            delete obj;
+        } else {
+            JSonArray* array = heap<JSonArray>();
+            for (auto& e : *array) {
+                if (e.is_container())
+                    work.emplace_back(std::move(e));
+            }
+            delete array;
+        }
+        set_tag(JSonValueType::Null);
+    }
+    bool is_container() const {
+        return type() == JSonValueType::Object || type() == JSonValueType::Array;
+    }
+
+    alignas(8) uint8_t m_data[16];
 };
 
+static_assert(sizeof(JSonValue) == 16, "JSonValue should stay 16 bytes");
+
 void json_dump(const JSonObject& obj);
+void json_dump_compact(const JSonObject& obj);
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "json_string.h"
+#include "parsec.h"
+
+// json lexer
+//
+// Turns input bytes into a flat array of tokens in a single pass, skipping
+// whitespace on the way, so grammars over TokenStream<JSonToken> never look
+// at individual chars. Strings and numbers are only delimited here; their
+// contents are checked and converted by the grammar. Input the lexer does not
+// recognize ends the token array with an Error token.
+
+enum class JSonTokenKind : uint8_t {
+    LBrace,
+    RBrace,
+    LBracket,
+    RBracket,
+    Colon,
+    Comma,
+    String,
+    Number,
+    True,
+    False,
+    Error
+};
+
+struct JSonToken {
+    size_t offset;   // first byte of the token text
+    uint32_t length; // quotes included for strings
+    JSonTokenKind kind;
+};
+
+using JSonTokenStream = TokenStream<JSonToken>;
+
+inline std::vector<JSonToken> json_lex(const std::vector<uint8_t>& data)
+{
+    std::vector<JSonToken> tokens;
+    tokens.reserve(data.size() / 4);
+
+    const uint8_t* begin = data.data();
+    const uint8_t* end = begin + data.size();
+    const uint8_t* p = begin;
+
+    auto push = [&tokens, begin](JSonTokenKind kind, const uint8_t* start, const uint8_t* stop) {
+        tokens.push_back(JSonToken{(size_t)(start - begin), (uint32_t)(stop - start), kind});
+    };
+
+    auto keyword = [&p, end](const char* str, size_t len) {
+        return (size_t)(end - p) >= len && memcmp(p, str, len) == 0;
+    };
+
+    while (p < end) {
+        const uint8_t* start = p;
+        switch (*p) {
+        case ' ': case '\t': case '\r': case '\n':
+            ++p;
+            continue;
+        case '{': push(JSonTokenKind::LBrace, p, p + 1); ++p; continue;
+        case '}': push(JSonTokenKind::RBrace, p, p + 1); ++p; continue;
+        case '[': push(JSonTokenKind::LBracket, p, p + 1); ++p; continue;
+        case ']': push(JSonTokenKind::RBracket, p, p + 1); ++p; continue;
+        case ':': push(JSonTokenKind::Colon, p, p + 1); ++p; continue;
+        case ',': push(JSonTokenKind::Comma, p, p + 1); ++p; continue;
+        case '"':
+            ++p;
+            while (1) {
+                p = json_string_scan(p, end);
+                if (p == end || *p == '"')
+                    break;
+                p += (*p == '\\' && end - p > 1) ? 2 : 1;
+            }
+            if (p == end)
+                break;
+            ++p;
+            push(JSonTokenKind::String, start, p);
+            continue;
+        case 't':
+            if (!keyword("true", 4))
+                break;
+            p += 4;
+            push(JSonTokenKind::True, start, p);
+            continue;
+        case 'f':
+            if (!keyword("false", 5))
+                break;
+            p += 5;
+            push(JSonTokenKind::False, start, p);
+            continue;
+        default:
+            if (*p == '-')
+                ++p;
+            if (p == end || *p < '0' || *p > '9')
+                break;
+            while (p < end && *p >= '0' && *p <= '9')
+                ++p;
+            push(JSonTokenKind::Number, start, p);
+            continue;
+        }
+
+        push(JSonTokenKind::Error, start, end);
+        break;
+    }
+
+    return tokens;
+}
@@ -1,16 +1,32 @@
 #pragma once
 
 #include "json.h"
+#include "json_string.h"
 #include "parsec.h"
 
 // json parser
 
-Parser<std::string> property_name() {
-    return some(alphanumeric() | one_of(" _")) >>= [](std::string s) {
-        return unit(s);
+// quoted string, escapes decoded
+inline Parser<std::string> string_value() {
+    auto p = [](ParseStream& s) {
+        if (s.has_data() && s.peek() == '"') {
+            const uint8_t* b = s.data.data() + s.curpos() + 1;
+            const uint8_t* e = s.data.data() + s.data.size();
+            std::string r;
+            if (json_string_decode(b, e, &r)) {
+                s.setpos(b - s.data.data());
+                return std::make_pair(true, std::move(r));
+            }
+        }
+
+        return std::make_pair(false, std::string());
     };
+    return Parser<std::string>(std::move(p));
 }
 
+inline Parser<std::string> property_name() {
+    return token(string_value());
+}
 
 inline Parser<JSonObject> json_object();
 
@@ -39,17 +55,9 @@ inline Parser<int> value_parser() {
     return number();
 }
 
-// TODO: add escaped chars
-//      parse escape char followed by char
-Parser<std::string> string_value() {
-    return many(alphanumeric() | one_of(" _")) >>= [](std::string s) {
-        return unit(s);
-    };
-}
-
 template <>
 inline Parser<std::string> value_parser() {
-    return quoted(string_value());
+    return token(string_value());
 }
 
 template <>
@@ -63,10 +71,10 @@ inline Parser<JSonArray> json_array_rest();
 template <typename T>
 inline Parser<JSonArray> json_array_value() {
     return value_parser<T>() >>= [](T s) {
-        return json_array_rest() >>= [s = std::move(s)](JSonArray a) {
+        return json_array_rest() >>= [s = std::move(s)](JSonArray a) mutable {
             JSonArray r(std::move(a));
             r.emplace_back(JSonValue(std::move(s)));
-            return unit(std::move(r));
+            return unit_once(std::move(r));
         };    
     };    
 }
@@ -89,8 +97,10 @@ inline Parser<JSonArray> json_array() {
     return spaces_skip() >>= [](Empty) {
         return reserved_cstr("[") >>= [](Empty) {
             return json_array_contents() >>= [](JSonArray a) {
-                return reserved_cstr("]") >>= [a = std::move(a)](Empty) {
-                    return unit(std::move(a));
+                return reserved_cstr("]") >>= [a = std::move(a)](Empty) mutable {
+                    // elements are appended innermost first
+                    std::reverse(a.begin(), a.end());
+                    return unit_once(std::move(a));
                 };
             };
         };
@@ -101,26 +111,45 @@ inline Parser<JSonArray> json_array() {
 using JSonProperty = std::pair<std::string, JSonValue>;
 
 template <typename T>
-inline Parser<JSonProperty> json_value(std::string name) {
-    return value_parser<T>() >>= [name = std::move(name)](T t) {
-        return unit(std::make_pair(std::move(name), JSonValue(std::move(t))));
-    };
+inline Parser<JSonValue> json_value() {
+    return fmap([](T t) { return JSonValue(std::move(t)); }, value_parser<T>());
 }
 
-inline Parser<JSonProperty> json_value_array(std::string name) {
-    return json_array() >>= [name = std::move(name)](JSonArray a) {
-        return unit(std::make_pair(std::move(name), JSonValue(std::move(a))));
-    };
+inline Parser<JSonValue> json_value_array() {
+    return fmap([](JSonArray a) { return JSonValue(std::move(a)); }, json_array());
+}
+
+// Opt-in: try property value alternatives in the order they are seen in the
+// input rather than declaration order. Counters are shared by all properties.
+inline bool& json_adaptive_values() {
+    static bool enabled = false;
+    return enabled;
+}
+
+inline const std::shared_ptr<ChoiceStats>& json_value_stats() {
+    static std::shared_ptr<ChoiceStats> stats = std::make_shared<ChoiceStats>();
+    return stats;
 }
 
 inline Parser<JSonProperty> json_property() {
-    return quoted(property_name()) >>= [](std::string name) {
-        return reserved_cstr(":") >>= [name = std::move(name)](Empty) {
-            return json_value<std::string>(name)
-                 | json_value<bool>(name)
-                 | json_value<int>(name)
-                 | json_value<JSonObject>(name)
-                 | json_value_array(name);
+    return property_name() >>= [](std::string name) {
+        return reserved_cstr(":") >>= [name = std::move(name)](Empty) mutable {
+            auto value = json_adaptive_values()
+                       ? adaptive_choice<JSonValue, ParseStream>({
+                             json_value<std::string>(),
+                             json_value<bool>(),
+                             json_value<int>(),
+                             json_value<JSonObject>(),
+                             json_value_array()
+                         }, json_value_stats())
+                       : json_value<std::string>()
+                       | json_value<bool>()
+                       | json_value<int>()
+                       | json_value<JSonObject>()
+                       | json_value_array();
+            return std::move(value) >>= [name = std::move(name)](JSonValue v) mutable {
+                return unit_once(JSonProperty(std::move(name), std::move(v)));
+            };
         };
     };
 }
@@ -136,10 +165,10 @@ inline Parser<JSonObject> json_properties_rest() {
 
 inline Parser<JSonObject> json_properties() {
     return json_property() >>= [](JSonProperty p) {
-        return json_properties_rest() >>= [p = std::move(p)](JSonObject v) {
+        return json_properties_rest() >>= [p = std::move(p)](JSonObject v) mutable {
             JSonObject obj(std::move(v));
-            obj.emplace(p);
-            return unit(std::move(obj));
+            obj.emplace(std::move(p));
+            return unit_once(std::move(obj));
         };
     };
 }
@@ -148,8 +177,8 @@ inline Parser<JSonObject> json_object() {
     return spaces_skip() >>= [](Empty) {
         return reserved_cstr("{") >>= [](Empty) {
             return json_properties() >>= [](JSonObject obj) {
-                return reserved_cstr("}") >>= [obj = std::move(obj)](Empty) {
-                    return unit(std::move(obj));
+                return reserved_cstr("}") >>= [obj = std::move(obj)](Empty) mutable {
+                    return unit_once(std::move(obj));
                 };
             };
         };
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstring>
+
+#include "json.h"
+#include "json_string.h"
+#include "parsec.h"
+
+// json parser with an explicit stack
+//
+// Accepts the same language as json_object() from json_parser.h, but nesting
+// is tracked in a heap allocated frame stack instead of recursive combinator
+// invocations, so nesting depth costs one frame per level rather than a pile
+// of native std::function frames. Nesting deeper than max_depth is a parse
+// error.
+
+const size_t json_default_max_depth = 10000;
+
+struct JSonStackFrame {
+    bool is_array;
+    std::string name; // property name of the value being parsed in this object
+    JSonObject object;
+    JSonArray array;
+
+    explicit JSonStackFrame(bool a)
+        : is_array{a}
+    {}
+};
+
+inline void json_skip_spaces(ParseStream& s) {
+    while (s.has_data()) {
+        char c = s.peek();
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n')
+            break;
+        s.advance();
+    }
+}
+
+// reserved_cstr() equivalent for a single char
+inline bool json_expect(ParseStream& s, char c) {
+    if (!s.has_data() || s.peek() != c)
+        return false;
+
+    s.advance();
+    json_skip_spaces(s);
+    return true;
+}
+
+// token(string_value())
+inline bool json_quoted_string(ParseStream& s, std::string& r) {
+    if (!s.has_data() || s.peek() != '"')
+        return false;
+
+    const uint8_t* b = s.data.data() + s.curpos() + 1;
+    const uint8_t* e = s.data.data() + s.data.size();
+    if (!json_string_decode(b, e, &r))
+        return false;
+
+    s.setpos(b - s.data.data());
+    json_skip_spaces(s);
+    return true;
+}
+
+inline bool json_number(ParseStream& s, int& r) {
+    std::string str;
+    if (s.has_data() && s.peek() == '-')
+        str.push_back(s.next());
+
+    size_t n = str.size();
+    while (s.has_data() && is_digit(s.peek()))
+        str.push_back(s.next());
+
+    if (str.size() == n)
+        return false;
+
+    r = to_int(str);
+    return true;
+}
+
+inline Parser<JSonObject> json_object_iterative(size_t max_depth = json_default_max_depth) {
+    auto p = [max_depth](ParseStream& s) {
+        enum class State { Property, Value, Next };
+
+        std::vector<JSonStackFrame> stack;
+        State state = State::Property;
+
+        // later properties win, as in json_properties()
+        auto attach = [&stack](JSonValue&& v) {
+            JSonStackFrame& top = stack.back();
+            if (top.is_array) {
+                top.array.emplace_back(std::move(v));
+            } else {
+                top.object.erase(top.name);
+                top.object.emplace(std::move(top.name), std::move(v));
+                top.name.clear();
+            }
+        };
+
+        auto fail = []() {
+            return std::make_pair(false, JSonObject());
+        };
+
+        json_skip_spaces(s);
+        if (!json_expect(s, '{'))
+            return fail();
+        stack.emplace_back(false);
+
+        while (1) {
+            switch (state) {
+            case State::Property:
+                if (!json_quoted_string(s, stack.back().name) || !json_expect(s, ':'))
+                    return fail();
+                state = State::Value;
+                break;
+
+            case State::Value: {
+                if (!s.has_data())
+                    return fail();
+
+                char c = s.peek();
+                if (c == '"') {
+                    std::string str;
+                    if (!json_quoted_string(s, str))
+                        return fail();
+                    attach(JSonValue(std::move(str)));
+                    state = State::Next;
+                } else if (c == 't' || c == 'f') {
+                    bool b = (c == 't');
+                    const char* str = b ? "true" : "false";
+                    if (!match_string(s, str, strlen(str)))
+                        return fail();
+                    json_skip_spaces(s);
+                    attach(JSonValue(b));
+                    state = State::Next;
+                } else if (c == '-' || is_digit(c)) {
+                    int n = 0;
+                    if (!json_number(s, n))
+                        return fail();
+                    attach(JSonValue(n));
+                    state = State::Next;
+                } else if (c == '{' || (c == '[' && !stack.back().is_array)) {
+                    if (stack.size() >= max_depth)
+                        return fail();
+                    s.advance();
+                    json_skip_spaces(s);
+                    stack.emplace_back(c == '[');
+                    state = (c == '[') ? State::Value : State::Property;
+                } else {
+                    return fail();
+                }
+                break;
+            }
+
+            case State::Next: {
+                json_skip_spaces(s);
+                bool is_array = stack.back().is_array;
+                if (json_expect(s, ',')) {
+                    state = is_array ? State::Value : State::Property;
+                    break;
+                }
+
+                if (!json_expect(s, is_array ? ']' : '}'))
+                    return fail();
+
+                JSonStackFrame f(std::move(stack.back()));
+                stack.pop_back();
+                if (stack.empty())
+                    return std::make_pair(true, std::move(f.object));
+
+                if (f.is_array)
+                    attach(JSonValue(std::move(f.array)));
+                else
+                    attach(JSonValue(std::move(f.object)));
+                break;
+            }
+            }
+        }
+    };
+    return Parser<JSonObject>(std::move(p));
+}
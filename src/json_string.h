@@ -0,0 +1,279 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// json string decoding
+//
+// Plain runs are located 16 bytes at a time and appended in one go; text
+// containing non-ASCII bytes is validated 16 bytes at a time as well, and
+// only escapes drop to scalar code. Strings must be valid UTF-8, escapes
+// are decoded to UTF-8 and \u surrogates must come in pairs.
+
+// Returns the first byte in [p, end) that is a quote, a backslash,
+// a control char or non-ASCII, or end.
+inline const uint8_t* json_string_scan(const uint8_t* p, const uint8_t* end)
+{
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x20);
+
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        // signed compare: control chars and bytes >= 0x80 are both below 0x20
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                                 _mm_cmplt_epi8(v, space));
+        int mask = _mm_movemask_epi8(m);
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"' && *p != '\\' && *p >= 0x20 && *p < 0x80)
+        ++p;
+    return p;
+}
+
+// Validates one multibyte UTF-8 sequence at p and advances past it.
+// Rejects overlong forms, surrogates and code points above U+10FFFF.
+inline bool json_utf8_sequence(const uint8_t*& p, const uint8_t* end)
+{
+    uint8_t c = p[0];
+    size_t n;
+    uint8_t lo = 0x80, hi = 0xbf; // valid range of the second byte
+
+    if (c >= 0xc2 && c <= 0xdf) {
+        n = 2;
+    } else if (c >= 0xe0 && c <= 0xef) {
+        n = 3;
+        if (c == 0xe0)
+            lo = 0xa0;
+        else if (c == 0xed)
+            hi = 0x9f;
+    } else if (c >= 0xf0 && c <= 0xf4) {
+        n = 4;
+        if (c == 0xf0)
+            lo = 0x90;
+        else if (c == 0xf4)
+            hi = 0x8f;
+    } else {
+        return false;
+    }
+
+    if ((size_t)(end - p) < n || p[1] < lo || p[1] > hi)
+        return false;
+    for (size_t i = 2; i < n; ++i) {
+        if ((p[i] & 0xc0) != 0x80)
+            return false;
+    }
+
+    p += n;
+    return true;
+}
+
+// Validates text from p, a non-ASCII byte, up to the next quote, backslash
+// or control char and leaves p there (or at end). Mixed runs of multibyte
+// and ASCII text stay in this loop. With SSE2, each 16 byte block is turned
+// into bit masks of lead and continuation bytes; continuations must sit
+// exactly where the leads expect them, and the second byte after E0, ED,
+// F0 and F4 is range checked as in json_utf8_sequence(). A block always
+// starts on a sequence boundary: a sequence cut by the block end is left
+// for the next block.
+inline bool json_utf8_run(const uint8_t*& p, const uint8_t* end)
+{
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x20);
+    auto mask = [](__m128i m) { return (uint32_t)_mm_movemask_epi8(m); };
+    auto between = [](__m128i v, int8_t lo, int8_t hi) { // signed, inclusive
+        return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+    };
+
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i control = _mm_and_si128(_mm_cmplt_epi8(v, space), _mm_cmpgt_epi8(v, _mm_set1_epi8(-1)));
+        uint32_t non_ascii = mask(v);
+        uint32_t special = mask(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)), control));
+        if (!non_ascii && !special) {
+            p += 16;
+            continue;
+        }
+
+        // as signed bytes: 80-BF is -128..-65, C2-DF -62..-33, E0-EF -32..-17, F0-F4 -16..-12
+        uint32_t valid = special ? ((1u << __builtin_ctz(special)) - 1) : 0xffff;
+        uint32_t cont = mask(_mm_cmplt_epi8(v, _mm_set1_epi8(-64))) & valid;
+        uint32_t lead = mask(between(v, -62, -12)) & valid;
+        uint32_t lead34 = mask(between(v, -32, -12)) & valid;
+        uint32_t need = lead << 1;
+        uint32_t bad = non_ascii & valid & ~(cont | lead);
+
+        if (lead34) {
+            uint32_t lead4 = mask(between(v, -16, -12)) & valid;
+            need |= (lead34 << 2) | (lead4 << 3);
+
+            // each lane against the byte after it; lane 15 is a cut sequence
+            __m128i next = _mm_srli_si128(v, 1);
+            __m128i lt_a0 = _mm_cmplt_epi8(next, _mm_set1_epi8(-96));
+            __m128i lt_90 = _mm_cmplt_epi8(next, _mm_set1_epi8(-112));
+            __m128i e0 = _mm_and_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)0xe0)), lt_a0);
+            __m128i ed = _mm_andnot_si128(lt_a0, _mm_cmpeq_epi8(v, _mm_set1_epi8((char)0xed)));
+            __m128i f0 = _mm_and_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)0xf0)), lt_90);
+            __m128i f4 = _mm_andnot_si128(lt_90, _mm_cmpeq_epi8(v, _mm_set1_epi8((char)0xf4)));
+            bad |= mask(_mm_or_si128(_mm_or_si128(e0, ed), _mm_or_si128(f0, f4))) & valid & 0x7fff;
+        }
+
+        if ((bad | (need ^ cont)) & 0xffff)
+            return false;
+
+        if (special) {
+            // a sequence cut short by the special char is invalid
+            if (need & ~valid)
+                return false;
+            p += __builtin_ctz(special);
+            return true;
+        }
+
+        // a sequence running past the block starts at its last lead
+        p += (need >> 16) ? 31 - __builtin_clz(lead) : 16;
+    }
+#endif
+    while (p < end) {
+        uint8_t c = *p;
+        if (c < 0x80) {
+            if (c == '"' || c == '\\' || c < 0x20)
+                return true;
+            ++p;
+        } else if (!json_utf8_sequence(p, end)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline void json_utf8_append(std::string& out, uint32_t cp)
+{
+    if (cp < 0x80) {
+        out.push_back((char)cp);
+    } else if (cp < 0x800) {
+        out.push_back((char)(0xc0 | (cp >> 6)));
+        out.push_back((char)(0x80 | (cp & 0x3f)));
+    } else if (cp < 0x10000) {
+        out.push_back((char)(0xe0 | (cp >> 12)));
+        out.push_back((char)(0x80 | ((cp >> 6) & 0x3f)));
+        out.push_back((char)(0x80 | (cp & 0x3f)));
+    } else {
+        out.push_back((char)(0xf0 | (cp >> 18)));
+        out.push_back((char)(0x80 | ((cp >> 12) & 0x3f)));
+        out.push_back((char)(0x80 | ((cp >> 6) & 0x3f)));
+        out.push_back((char)(0x80 | (cp & 0x3f)));
+    }
+}
+
+// 4 hex digits following \u
+inline bool json_hex4(const uint8_t* p, const uint8_t* end, uint32_t& cp)
+{
+    if (end - p < 4)
+        return false;
+
+    cp = 0;
+    for (int i = 0; i < 4; ++i) {
+        uint8_t c = p[i];
+        uint32_t d;
+        if (c >= '0' && c <= '9')
+            d = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            d = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            d = c - 'A' + 10;
+        else
+            return false;
+        cp = (cp << 4) | d;
+    }
+    return true;
+}
+
+// Decodes the escape sequence at p (pointing at the backslash).
+inline bool json_string_escape(const uint8_t*& p, const uint8_t* end, std::string* out)
+{
+    if (end - p < 2)
+        return false;
+
+    char c;
+    switch (p[1]) {
+    case '"': c = '"'; break;
+    case '\\': c = '\\'; break;
+    case '/': c = '/'; break;
+    case 'b': c = '\b'; break;
+    case 'f': c = '\f'; break;
+    case 'n': c = '\n'; break;
+    case 'r': c = '\r'; break;
+    case 't': c = '\t'; break;
+    case 'u': {
+        uint32_t cp;
+        if (!json_hex4(p + 2, end, cp))
+            return false;
+        p += 6;
+
+        if (cp >= 0xdc00 && cp <= 0xdfff)
+            return false;
+        if (cp >= 0xd800 && cp <= 0xdbff) {
+            uint32_t lo;
+            if (end - p < 2 || p[0] != '\\' || p[1] != 'u' || !json_hex4(p + 2, end, lo))
+                return false;
+            if (lo < 0xdc00 || lo > 0xdfff)
+                return false;
+            p += 6;
+            cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+        }
+
+        if (out)
+            json_utf8_append(*out, cp);
+        return true;
+    }
+    default:
+        return false;
+    }
+
+    p += 2;
+    if (out)
+        out->push_back(c);
+    return true;
+}
+
+// Decodes string contents starting right after the opening quote and
+// advances p past the closing quote. Decoded text is appended to out;
+// with out == nullptr the string is only validated.
+inline bool json_string_decode(const uint8_t*& p, const uint8_t* end, std::string* out)
+{
+    const uint8_t* run = p;
+    while (1) {
+        p = json_string_scan(p, end);
+        if (p == end)
+            return false;
+
+        uint8_t c = *p;
+        if (c >= 0x80) {
+            if (!json_utf8_run(p, end))
+                return false;
+            continue;
+        }
+
+        if (out)
+            out->append((const char*)run, p - run);
+
+        if (c == '"') {
+            ++p;
+            return true;
+        }
+        if (c < 0x20 || !json_string_escape(p, end, out))
+            return false;
+
+        run = p;
+    }
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "json.h"
+#include "json_lexer.h"
+#include "parsec.h"
+
+// json parser over lexed tokens
+//
+// Same grammar as json_parser.h, but the combinators run over the token array
+// produced by json_lex(), so alternatives fail on a single token kind compare
+// and whitespace is already gone.
+
+template <typename T>
+using JSonTokParser = Parser<T, JSonTokenStream>;
+
+inline JSonTokParser<JSonToken> json_tok(JSonTokenKind kind) {
+    auto p = [kind](JSonTokenStream& s) {
+        if (s.has_data() && s.peek().kind == kind)
+            return std::make_pair(true, s.next());
+
+        return std::make_pair(false, JSonToken());
+    };
+    return JSonTokParser<JSonToken>(std::move(p));
+}
+
+inline JSonTokParser<Empty> json_tok_skip(JSonTokenKind kind) {
+    auto p = [kind](JSonTokenStream& s) {
+        if (s.has_data() && s.peek().kind == kind) {
+            s.advance();
+            return std::make_pair(true, Empty());
+        }
+
+        return std::make_pair(false, Empty());
+    };
+    return JSonTokParser<Empty>(std::move(p));
+}
+
+// string token, escapes decoded
+inline JSonTokParser<std::string> json_tok_string() {
+    auto p = [](JSonTokenStream& s) {
+        if (s.has_data() && s.peek().kind == JSonTokenKind::String) {
+            JSonToken t = s.peek();
+            const uint8_t* b = (const uint8_t*)s.text(t) + 1;
+            const uint8_t* e = (const uint8_t*)s.text(t) + t.length;
+            std::string r;
+            if (json_string_decode(b, e, &r) && b == e) {
+                s.advance();
+                return std::make_pair(true, std::move(r));
+            }
+        }
+
+        return std::make_pair(false, std::string());
+    };
+    return JSonTokParser<std::string>(std::move(p));
+}
+
+inline JSonTokParser<JSonObject> json_tok_object();
+
+template <typename T>
+inline JSonTokParser<T> json_tok_value_parser();
+
+template <>
+inline JSonTokParser<bool> json_tok_value_parser() {
+    auto p = [](JSonTokenStream& s) {
+        if (s.has_data()) {
+            JSonTokenKind kind = s.peek().kind;
+            if (kind == JSonTokenKind::True || kind == JSonTokenKind::False) {
+                s.advance();
+                return std::make_pair(true, kind == JSonTokenKind::True);
+            }
+        }
+
+        return std::make_pair(false, false);
+    };
+    return JSonTokParser<bool>(std::move(p));
+}
+
+template <>
+inline JSonTokParser<int> json_tok_value_parser() {
+    auto p = [](JSonTokenStream& s) {
+        if (s.has_data() && s.peek().kind == JSonTokenKind::Number) {
+            JSonToken t = s.next();
+            return std::make_pair(true, to_int(std::string(s.text(t), t.length)));
+        }
+
+        return std::make_pair(false, 0);
+    };
+    return JSonTokParser<int>(std::move(p));
+}
+
+template <>
+inline JSonTokParser<std::string> json_tok_value_parser() {
+    return json_tok_string();
+}
+
+template <>
+inline JSonTokParser<JSonObject> json_tok_value_parser() {
+    return json_tok_object();
+}
+
+// array
+inline JSonTokParser<JSonArray> json_tok_array_rest();
+
+template <typename T>
+inline JSonTokParser<JSonArray> json_tok_array_value() {
+    return json_tok_value_parser<T>() >>= [](T s) {
+        return json_tok_array_rest() >>= [s = std::move(s)](JSonArray a) mutable {
+            JSonArray r(std::move(a));
+            r.emplace_back(JSonValue(std::move(s)));
+            return unit_once<JSonArray, JSonTokenStream>(std::move(r));
+        };
+    };
+}
+
+inline JSonTokParser<JSonArray> json_tok_array_contents() {
+    return json_tok_array_value<std::string>()
+         | json_tok_array_value<bool>()
+         | json_tok_array_value<int>()
+         | json_tok_array_value<JSonObject>();
+}
+
+inline JSonTokParser<JSonArray> json_tok_array_rest() {
+    return (json_tok_skip(JSonTokenKind::Comma) >>= [](Empty) { return json_tok_array_contents(); })
+        | unit<JSonArray, JSonTokenStream>(JSonArray());
+}
+
+inline JSonTokParser<JSonArray> json_tok_array() {
+    return json_tok_skip(JSonTokenKind::LBracket) >>= [](Empty) {
+        return json_tok_array_contents() >>= [](JSonArray a) {
+            return json_tok_skip(JSonTokenKind::RBracket) >>= [a = std::move(a)](Empty) mutable {
+                // elements are appended innermost first
+                std::reverse(a.begin(), a.end());
+                return unit_once<JSonArray, JSonTokenStream>(std::move(a));
+            };
+        };
+    };
+}
+
+// property
+using JSonProperty = std::pair<std::string, JSonValue>;
+
+template <typename T>
+inline JSonTokParser<JSonValue> json_tok_value() {
+    return fmap([](T t) { return JSonValue(std::move(t)); }, json_tok_value_parser<T>());
+}
+
+inline JSonTokParser<JSonValue> json_tok_value_array() {
+    return fmap([](JSonArray a) { return JSonValue(std::move(a)); }, json_tok_array());
+}
+
+inline JSonTokParser<JSonProperty> json_tok_property() {
+    return json_tok_string() >>= [](std::string name) {
+        return json_tok_skip(JSonTokenKind::Colon) >>= [name = std::move(name)](Empty) mutable {
+            auto value = json_tok_value<std::string>()
+                       | json_tok_value<bool>()
+                       | json_tok_value<int>()
+                       | json_tok_value<JSonObject>()
+                       | json_tok_value_array();
+            return std::move(value) >>= [name = std::move(name)](JSonValue v) mutable {
+                return unit_once<JSonProperty, JSonTokenStream>(JSonProperty(std::move(name), std::move(v)));
+            };
+        };
+    };
+}
+
+inline JSonTokParser<JSonObject> json_tok_properties();
+
+inline JSonTokParser<JSonObject> json_tok_properties_rest() {
+    return (json_tok_skip(JSonTokenKind::Comma) >>= [](Empty) { return json_tok_properties(); })
+        | unit<JSonObject, JSonTokenStream>(JSonObject());
+}
+
+inline JSonTokParser<JSonObject> json_tok_properties() {
+    return json_tok_property() >>= [](JSonProperty p) {
+        return json_tok_properties_rest() >>= [p = std::move(p)](JSonObject v) mutable {
+            JSonObject obj(std::move(v));
+            obj.emplace(std::move(p));
+            return unit_once<JSonObject, JSonTokenStream>(std::move(obj));
+        };
+    };
+}
+
+inline JSonTokParser<JSonObject> json_tok_object() {
+    return json_tok_skip(JSonTokenKind::LBrace) >>= [](Empty) {
+        return json_tok_properties() >>= [](JSonObject obj) {
+            return json_tok_skip(JSonTokenKind::RBrace) >>= [obj = std::move(obj)](Empty) mutable {
+                return unit_once<JSonObject, JSonTokenStream>(std::move(obj));
+            };
+        };
+    };
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "json_string.h"
+
+// json validator
+//
+// Checks input against the same language as json_object_iterative() without
+// building any values. Open containers are tracked one bit per level in a
+// fixed bitset and strings are run through json_string_decode() in validate
+// only mode, so nothing is allocated whatever the input size.
+
+const size_t json_validate_depth_limit = 1 << 16;
+
+struct JSonStats {
+    size_t bytes = 0;
+    size_t values = 0;
+    size_t max_depth = 0;
+};
+
+inline const uint8_t* json_skip_ws(const uint8_t* p, const uint8_t* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        ++p;
+    return p;
+}
+
+inline bool json_validate(const uint8_t* data, size_t size, JSonStats& stats,
+                          size_t max_depth = json_validate_depth_limit)
+{
+    enum class State { Property, Value, Next };
+
+    uint64_t arrays[json_validate_depth_limit / 64]; // bit set: level is an array
+    size_t depth = 0;
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    State state = State::Property;
+
+    if (max_depth > json_validate_depth_limit)
+        max_depth = json_validate_depth_limit;
+
+    stats.bytes = size;
+    stats.values = 0;
+    stats.max_depth = 0;
+
+    auto in_array = [&arrays, &depth]() {
+        return (arrays[(depth - 1) / 64] >> ((depth - 1) % 64)) & 1;
+    };
+
+    p = json_skip_ws(p, end);
+    if (p == end || *p != '{' || max_depth == 0)
+        return false;
+    p = json_skip_ws(p + 1, end);
+    arrays[0] = 0;
+    depth = 1;
+    stats.values = 1;
+    stats.max_depth = 1;
+
+    while (1) {
+        switch (state) {
+        case State::Property:
+            if (p == end || *p != '"')
+                return false;
+            ++p;
+            if (!json_string_decode(p, end, nullptr))
+                return false;
+            p = json_skip_ws(p, end);
+            if (p == end || *p != ':')
+                return false;
+            p = json_skip_ws(p + 1, end);
+            state = State::Value;
+            break;
+
+        case State::Value: {
+            if (p == end)
+                return false;
+
+            uint8_t c = *p;
+            ++stats.values;
+            if (c == '"') {
+                ++p;
+                if (!json_string_decode(p, end, nullptr))
+                    return false;
+                state = State::Next;
+            } else if (c == 't') {
+                if (end - p < 4 || memcmp(p, "true", 4))
+                    return false;
+                p += 4;
+                state = State::Next;
+            } else if (c == 'f') {
+                if (end - p < 5 || memcmp(p, "false", 5))
+                    return false;
+                p += 5;
+                state = State::Next;
+            } else if (c == '-' || (c >= '0' && c <= '9')) {
+                if (c == '-')
+                    ++p;
+                const uint8_t* digits = p;
+                while (p < end && *p >= '0' && *p <= '9')
+                    ++p;
+                if (p == digits)
+                    return false;
+                state = State::Next;
+            } else if (c == '{' || (c == '[' && !in_array())) {
+                if (depth >= max_depth)
+                    return false;
+                uint64_t& word = arrays[depth / 64];
+                uint64_t bit = (uint64_t)1 << (depth % 64);
+                if (depth % 64 == 0)
+                    word = 0;
+                if (c == '[')
+                    word |= bit;
+                else
+                    word &= ~bit;
+                ++depth;
+                if (depth > stats.max_depth)
+                    stats.max_depth = depth;
+                p = json_skip_ws(p + 1, end);
+                state = (c == '[') ? State::Value : State::Property;
+            } else {
+                return false;
+            }
+            break;
+        }
+
+        case State::Next: {
+            p = json_skip_ws(p, end);
+            if (p == end)
+                return false;
+
+            bool is_array = in_array();
+            if (*p == ',') {
+                p = json_skip_ws(p + 1, end);
+                state = is_array ? State::Value : State::Property;
+                break;
+            }
+
+            if (*p != (is_array ? ']' : '}'))
+                return false;
+            p = json_skip_ws(p + 1, end);
+            if (--depth == 0)
+                return p == end;
+            break;
+        }
+        }
+    }
+}
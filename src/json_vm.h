@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstring>
+
+#include "parsec.h"
+#include "parsec_vm.h"
+
+// json grammar for the parsing machine
+//
+// Recognizes the same language as json_object() from json_parser.h. Only
+// objects and arrays are rules, so the depth of rule calls in vm::match()
+// is the nesting depth of the document.
+
+inline vm::Grammar json_vm_grammar() {
+    using vm::Grammar;
+    using vm::Pattern;
+    using vm::bind;
+    using vm::empty;
+    using vm::many;
+    using vm::one_of;
+    using vm::rule;
+    using vm::seq;
+    using vm::some;
+    using vm::string;
+
+    Pattern ws = many(one_of(" \t\r\n"));
+    auto token = [&ws](Pattern p) { return bind(std::move(p), ws); };
+    auto range = [](int lo, int hi) {
+        return vm::satisfy([lo, hi](char c) { return (uint8_t)c >= lo && (uint8_t)c <= hi; });
+    };
+
+    // string contents, same checks as json_string_decode()
+    Pattern plain = vm::satisfy([](char c) { return (uint8_t)c >= 0x20 && (uint8_t)c < 0x80 && c != '"' && c != '\\'; });
+    Pattern hex = one_of("0123456789abcdefABCDEF");
+    Pattern high = seq({string("\\u"), one_of("dD"), one_of("89abAB"), hex, hex});
+    Pattern low = seq({string("\\u"), one_of("dD"), one_of("cdefCDEF"), hex, hex});
+    Pattern bmp = bind(string("\\u"), bind(one_of("0123456789abcefABCEF"), hex) | bind(one_of("dD"), range('0', '7')));
+    Pattern escape = bind(string("\\"), one_of("\"\\/bfnrt"))
+                   | bind(high, low)
+                   | seq({bmp, hex, hex});
+    Pattern tail = range(0x80, 0xbf);
+    Pattern utf8 = seq({range(0xc2, 0xdf), tail})
+                 | seq({string("\xe0"), range(0xa0, 0xbf), tail})
+                 | seq({range(0xe1, 0xec), tail, tail})
+                 | seq({string("\xed"), range(0x80, 0x9f), tail})
+                 | seq({range(0xee, 0xef), tail, tail})
+                 | seq({string("\xf0"), range(0x90, 0xbf), tail, tail})
+                 | seq({range(0xf1, 0xf3), tail, tail, tail})
+                 | seq({string("\xf4"), range(0x80, 0x8f), tail, tail});
+
+    Pattern string_value = token(seq({string("\""), many(some(plain) | escape | utf8), string("\"")}));
+    Pattern bool_value = token(string("true") | string("false"));
+    Pattern number = bind(string("-") | empty(), some(vm::satisfy(is_digit)));
+    Pattern array_item = string_value | bool_value | number | rule("object");
+
+    Pattern property = seq({
+        string_value, token(string(":")),
+        string_value | bool_value | number | rule("object") | rule("array")
+    });
+
+    Grammar g;
+    g.define("object", seq({
+        ws, token(string("{")),
+        property, ws,
+        many(seq({token(string(",")), property, ws})),
+        token(string("}"))
+    }));
+    g.define("array", seq({
+        ws, token(string("[")),
+        array_item, ws,
+        many(seq({token(string(",")), array_item, ws})),
+        token(string("]"))
+    }));
+    return g;
+}
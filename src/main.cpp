@@ -1,27 +1,40 @@
+#include <cctype>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <vector>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "json_parser.h"
+#include "json_stack_parser.h"
+#include "json_token_parser.h"
+#include "json_validate.h"
+#include "json_vm.h"
 
 static std::vector<uint8_t> load_file(FILE* f) 
 {
     std::vector<uint8_t> data;
     while (1) {
-        char buf[256];
-        if (!fgets(buf, sizeof(buf), f))
-            break;        
-        data.insert(data.end(), (uint8_t*)&buf[0], (uint8_t*)&buf[strlen(buf)]);
+        uint8_t buf[1 << 16];
+        size_t n = fread(buf, 1, sizeof(buf), f);
+        if (!n)
+            break;
+        data.insert(data.end(), &buf[0], &buf[n]);
     }
     return data;
 }
 
-static std::vector<uint8_t> get_input(int argc, const char** argv)
+static std::vector<uint8_t> get_input(const char* file_name)
 {
-    if (argc > 1) {
-        const char* file_name = argv[1];
-        FILE* f = fopen(file_name, "r");
+    if (file_name) {
+        FILE* f = fopen(file_name, "rb");
         if (!f) {
             printf("cannot open file \"%s\"\n", file_name);
             exit(-1);
@@ -35,15 +48,181 @@ static std::vector<uint8_t> get_input(int argc, const char** argv)
     return load_file(stdin);
 }
 
+// Read only view of the input for the validating modes. Files are mapped
+// where possible so large inputs are not copied; otherwise the data is read.
+struct Input {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    void* map = nullptr;
+    std::vector<uint8_t> buf;
+
+    Input() = default;
+    Input(const Input&) = delete;
+    Input& operator=(const Input&) = delete;
+
+    ~Input() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (map)
+            munmap(map, size);
+#endif
+    }
+};
+
+static void map_input(const char* file_name, Input& in)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    if (file_name) {
+        int fd = open(file_name, O_RDONLY);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m != MAP_FAILED) {
+                madvise(m, st.st_size, MADV_SEQUENTIAL);
+                close(fd);
+                in.map = m;
+                in.data = (const uint8_t*)m;
+                in.size = st.st_size;
+                return;
+            }
+        }
+        if (fd >= 0)
+            close(fd);
+    }
+#endif
+    in.buf = get_input(file_name);
+    in.data = in.buf.data();
+    in.size = in.buf.size();
+}
+
+static void print_choice_stats(const ChoiceStats& st)
+{
+    static const char* names[] = { "string", "bool", "number", "object", "array" };
+
+    fprintf(stderr, "value alternatives: %llu runs, %llu reorders, order",
+            (unsigned long long)st.runs, (unsigned long long)st.reorders);
+    for (size_t i : st.order)
+        fprintf(stderr, " %s", names[i]);
+    fprintf(stderr, "\n");
+
+    for (size_t i = 0; i < st.attempts.size(); ++i) {
+        fprintf(stderr, "  %-8s attempts %llu, successes %llu\n", names[i],
+                (unsigned long long)st.attempts[i], (unsigned long long)st.successes[i]);
+    }
+}
+
+static void usage()
+{
+    printf("usage: parsec [--validate | --minify | --stats] [--iterative | --tokens | --vm] [--adaptive] [--max-depth N] [file]\n");
+    exit(-1);
+}
+
 int main(int argc, const char** argv)
 {
-    auto p = json_object();
-    auto r = run_parser(p, ParseStream(get_input(argc, argv)));
+    enum class Mode { Dump, Minify, Validate, Stats };
+    enum class Engine { Combinators, Iterative, Tokens, Vm };
 
-    if (r.first)
-        json_dump(r.second);
-    else
+    const char* file_name = nullptr;
+    Mode mode = Mode::Dump;
+    Engine engine = Engine::Combinators;
+    size_t max_depth = 0; // not given
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--validate")) {
+            mode = Mode::Validate;
+        } else if (!strcmp(argv[i], "--minify")) {
+            mode = Mode::Minify;
+        } else if (!strcmp(argv[i], "--stats")) {
+            mode = Mode::Stats;
+        } else if (!strcmp(argv[i], "--iterative")) {
+            engine = Engine::Iterative;
+        } else if (!strcmp(argv[i], "--tokens")) {
+            engine = Engine::Tokens;
+        } else if (!strcmp(argv[i], "--vm")) {
+            engine = Engine::Vm;
+        } else if (!strcmp(argv[i], "--adaptive")) {
+            json_adaptive_values() = true;
+        } else if (!strcmp(argv[i], "--max-depth")) {
+            if (++i == argc)
+                usage();
+            char* end = nullptr;
+            max_depth = strtoul(argv[i], &end, 10);
+            if (!isdigit((unsigned char)argv[i][0]) || *end || !max_depth)
+                usage();
+        } else if (argv[i][0] == '-' || file_name) {
+            usage();
+        } else {
+            file_name = argv[i];
+        }
+    }
+
+    // the parsing machine only recognizes input
+    if (engine == Engine::Vm && mode == Mode::Dump)
+        mode = Mode::Validate;
+
+    bool builds_dom = (mode == Mode::Dump || mode == Mode::Minify);
+    // validation runs json_validate() or the parsing machine, never a dom parser
+    if (builds_dom ? engine == Engine::Vm : (engine == Engine::Iterative || engine == Engine::Tokens))
+        usage();
+    if (mode == Mode::Stats && engine == Engine::Vm)
+        usage();
+
+    // the validating modes build nothing, so nesting only costs a bit per level
+    if (!max_depth)
+        max_depth = builds_dom ? json_default_max_depth : json_validate_depth_limit;
+    else if (!builds_dom && max_depth > json_validate_depth_limit)
+        max_depth = json_validate_depth_limit;
+
+    if (!builds_dom) {
+        Input in;
+        map_input(file_name, in);
+
+        bool ok;
+        JSonStats stats;
+        auto start = std::chrono::steady_clock::now();
+        if (engine == Engine::Vm) {
+            vm::Program prog;
+            vm::compile(json_vm_grammar(), "object", prog);
+
+            size_t end = 0;
+            ok = vm::match(prog, in.data, in.size, end, max_depth) && end == in.size;
+        } else {
+            ok = json_validate(in.data, in.size, stats, max_depth);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        printf(ok ? "ok\n" : "parse error\n");
+        if (mode == Mode::Stats) {
+            double secs = elapsed.count();
+            printf("bytes %zu\n", stats.bytes);
+            printf("values %zu\n", stats.values);
+            printf("max depth %zu\n", stats.max_depth);
+            printf("time %.6f s\n", secs);
+            printf("throughput %.1f MB/s\n", secs > 0 ? stats.bytes / secs / 1e6 : 0.0);
+        }
+        return ok ? 0 : 1;
+    }
+
+    std::vector<uint8_t> data = get_input(file_name);
+
+    std::pair<bool, JSonObject> r;
+    if (engine == Engine::Tokens) {
+        std::vector<JSonToken> toks = json_lex(data);
+        r = run_parser(json_tok_object(), JSonTokenStream(std::move(data), std::move(toks)));
+    } else {
+        auto p = (engine == Engine::Iterative) ? json_object_iterative(max_depth) : json_object();
+        r = run_parser(p, ParseStream(std::move(data)));
+    }
+
+    if (!r.first)
         printf("parse error\n");
+    else if (mode == Mode::Minify)
+        json_dump_compact(r.second);
+    else
+        json_dump(r.second);
+
+    // only the byte level combinator grammar uses adaptive choice
+    if (json_adaptive_values() && json_value_stats()->runs)
+        print_choice_stats(*json_value_stats());
 
-    return 0;
+    return r.first ? 0 : 1;
 }
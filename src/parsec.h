@@ -1,12 +1,20 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <functional>
+#include <memory>
 #include <utility>
 
+// Parse streams
+// Combinators are generic over the stream type. A stream provides
+// value_type, peek/next/advance, curpos/setpos for rewinding and has_data/empty.
+
 // TODO: replace parse stream with immutable container and iterators
 struct ParseStream {
+    using value_type = char;
+
     std::vector<uint8_t> data;
     size_t pos = 0;
 
@@ -31,9 +39,45 @@ struct ParseStream {
     bool empty() const { return !has_data(); }
 };
 
-template <typename T>
+// Stream of pre-lexed tokens. Tok needs offset and length members
+// locating the token text in the source buffer.
+template <typename Tok>
+struct TokenStream {
+    using value_type = Tok;
+
+    std::vector<uint8_t> source;
+    std::vector<Tok> tokens;
+    size_t pos = 0;
+
+    TokenStream() = delete;
+    TokenStream(std::vector<uint8_t> src, std::vector<Tok> toks)
+        : source{std::move(src)}
+        , tokens{std::move(toks)}
+    {}
+
+    const Tok& peek() const {
+        return tokens[pos];
+    }
+    void advance() {
+        ++pos;
+    }
+    size_t curpos() const { return pos; }
+    void setpos(size_t a) { pos = a; }
+
+    Tok next() {
+        return tokens[pos++];
+    }
+    bool has_data() const { return pos < tokens.size(); }
+    bool empty() const { return !has_data(); }
+
+    const char* text(const Tok& t) const {
+        return (const char*)&source[t.offset];
+    }
+};
+
+template <typename T, typename S = ParseStream>
 struct Parser {
-    using ParseFunc = std::function<std::pair<bool, T>(ParseStream&)>;
+    using ParseFunc = std::function<std::pair<bool, T>(S&)>;
     ParseFunc parse;
 
     Parser() = delete;
@@ -46,44 +90,44 @@ struct Parser {
     {}
 };
 
-template <typename T>
-inline std::pair<bool, T> run_parser(const Parser<T>& p, ParseStream&& s) {
+template <typename T, typename S>
+inline std::pair<bool, T> run_parser(const Parser<T, S>& p, S&& s) {
     auto r = p.parse(s);
     if (r.first && s.empty())
-        return std::make_pair(true, r.second);
+        return std::make_pair(true, std::move(r.second));
 
     return std::make_pair(false, T());
 }
 
 // Functor
 // fmap :: (a -> b) -> f a -> f b
-template <typename F, typename T, typename U = typename std::result_of<F(T)>::type>
-inline Parser<U> fmap(F&& f, const Parser<T>& p) {
-    auto r = [f, p](ParseStream& s) -> std::pair<bool, U> {
+template <typename F, typename T, typename S, typename U = typename std::result_of<F(T)>::type>
+inline Parser<U, S> fmap(F&& f, Parser<T, S> p) {
+    auto r = [f = std::forward<F>(f), p = std::move(p)](S& s) -> std::pair<bool, U> {
         auto a = p.parse(s);
         if (a.first)
-            return std::make_pair(true, f(a.second));
+            return std::make_pair(true, f(std::move(a.second)));
 
         return std::make_pair(false, U());
     };
-    return Parser<U>(r);
+    return Parser<U, S>(std::move(r));
 }
 
 // Applicative
 // (<*>) :: f (a -> b) -> f a -> f b 
-template <typename F, typename T, typename U = typename std::result_of<F(T)>::type>
-inline Parser<U> applicative(const Parser<F>& fp, const Parser<T>& p) {
-    auto r = [fp, p](ParseStream& s) -> std::pair<bool, U> {
+template <typename F, typename T, typename S, typename U = typename std::result_of<F(T)>::type>
+inline Parser<U, S> applicative(Parser<F, S> fp, Parser<T, S> p) {
+    auto r = [fp = std::move(fp), p = std::move(p)](S& s) -> std::pair<bool, U> {
         auto f = fp.parse(s);
         if (f.first) {
             auto a = p.parse(s);
             if (a.first)
-                return std::make_pair(true, f.second(a.second));
+                return std::make_pair(true, f.second(std::move(a.second)));
         }
 
         return std::make_pair(false, U());
     };
-    return Parser<U>(r);
+    return Parser<U, S>(std::move(r));
 }
 
 template <typename T>
@@ -91,51 +135,66 @@ struct Result {
     using type = T;
 };
 
-template <typename T>
-struct Result <Parser<T>> {
+template <typename T, typename S>
+struct Result <Parser<T, S>> {
     using type = T;
 };
 
+// Results are handed on as rvalues: the continuation receives the parsed
+// value by move and may move its captures into the parser it returns, as that
+// parser is built for a single run. Continuations doing so are mutable.
+
 // Monad
 // bind :: Parser a -> (a -> Parser b) -> Parser b
-template <typename F, typename T, typename U = typename Result<typename std::result_of<F(T)>::type>::type>
-inline Parser<U> bind(Parser<T> p, F&& f) {
-    auto r = [p = std::move(p), f](ParseStream& s) -> std::pair<bool, U> {
+template <typename F, typename T, typename S, typename U = typename Result<typename std::result_of<F(T)>::type>::type>
+inline Parser<U, S> bind(Parser<T, S> p, F&& f) {
+    auto r = [p = std::move(p), f = std::forward<F>(f)](S& s) mutable -> std::pair<bool, U> {
         auto a = p.parse(s);
         if (a.first)
-            return f(a.second).parse(s);
+            return f(std::move(a.second)).parse(s);
 
         return std::make_pair(false, U());
     };
-    return Parser<U>(r);
+    return Parser<U, S>(std::move(r));
 }
 
 // bind operator
-template <typename F, typename T, typename U = typename Result<typename std::result_of<F(T)>::type>::type>
-inline auto operator>>=(Parser<T> p, F&& f) -> Parser<U> {
-    return bind(std::move(p), std::move(f));
+template <typename F, typename T, typename S, typename U = typename Result<typename std::result_of<F(T)>::type>::type>
+inline auto operator>>=(Parser<T, S> p, F&& f) -> Parser<U, S> {
+    return bind(std::move(p), std::forward<F>(f));
 }
 
 // Monad unit
-template <typename T>
-inline Parser<T> unit(T t) {
-    auto p = [t = std::move(t)](ParseStream&) {
+template <typename T, typename S = ParseStream>
+inline Parser<T, S> unit(T t) {
+    auto p = [t = std::move(t)](S&) {
+        return std::make_pair(true, t);
+    };
+    return Parser<T, S>(std::move(p));
+}
+
+// unit that moves its value out, so the parser yields it only once. Meant
+// for the "return x" at the end of a continuation, where the parser is
+// built per run and would otherwise copy x.
+template <typename T, typename S = ParseStream>
+inline Parser<T, S> unit_once(T t) {
+    auto p = [t = std::move(t)](S&) mutable {
         return std::make_pair(true, std::move(t));
     };
-    return Parser<T>(p);
+    return Parser<T, S>(std::move(p));
 }
 
-template <typename T>
-inline Parser<T> failure() {
-    auto p = [](ParseStream&) {
+template <typename T, typename S = ParseStream>
+inline Parser<T, S> failure() {
+    auto p = [](S&) {
         return std::make_pair(false, T());
     };
-    return Parser<T>(p);
+    return Parser<T, S>(std::move(p));
 }
 
-template <typename T>
-inline Parser<T> option(const Parser<T>& p, const Parser<T>& q) {    
-    auto r = [p, q](ParseStream& s) {
+template <typename T, typename S>
+inline Parser<T, S> option(Parser<T, S> p, Parser<T, S> q) {    
+    auto r = [p = std::move(p), q = std::move(q)](S& s) {
         size_t pos = s.curpos();
         auto a = p.parse(s);
         if (a.first)
@@ -144,88 +203,177 @@ inline Parser<T> option(const Parser<T>& p, const Parser<T>& q) {
         s.setpos(pos); // rewind
         return q.parse(s);
     };
-    return Parser<T>(r);
-}
+    return Parser<T, S>(std::move(r));
+}
+
+template <typename T, typename S>
+inline Parser<T, S> operator|(Parser<T, S> p, Parser<T, S> q) {
+    return option(std::move(p), std::move(q));
+}
+
+// Counters of an adaptive_choice(), shared by every parser built with them.
+// attempts/successes are per alternative, in declaration order; order is
+// the current try order. Alternatives are ranked by recent, a success count
+// halved on each reorder so the order follows recent input.
+struct ChoiceStats {
+    std::vector<uint64_t> attempts;
+    std::vector<uint64_t> successes;
+    std::vector<uint64_t> recent;
+    std::vector<size_t> order;
+    uint64_t runs = 0;
+    uint64_t reorders = 0;
+
+    void reset(size_t n) {
+        attempts.assign(n, 0);
+        successes.assign(n, 0);
+        recent.assign(n, 0);
+        order.resize(n);
+        for (size_t i = 0; i < n; ++i)
+            order[i] = i;
+        runs = 0;
+        reorders = 0;
+    }
 
-template <typename T>
-inline Parser<T> operator|(const Parser<T>& p, const Parser<T>& q) {
-    return option(p, q);
+    void reorder() {
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return recent[a] > recent[b];
+        });
+        for (auto& n : recent)
+            n -= n / 2;
+        ++reorders;
+    }
+};
+
+// Like chaining alternatives with option(), but every period runs the
+// alternatives are reordered by how often they succeeded. When at most one
+// alternative can succeed on any input, the result is the same as ordered
+// choice; otherwise the most successful overlapping alternative wins.
+// A period of 0 is taken as 1, reordering before every run.
+template <typename T, typename S>
+inline Parser<T, S> adaptive_choice(std::vector<Parser<T, S>> alts,
+                                    std::shared_ptr<ChoiceStats> stats = nullptr,
+                                    uint64_t period = 256) {
+    if (period == 0)
+        period = 1;
+    if (!stats)
+        stats = std::make_shared<ChoiceStats>();
+    if (stats->order.size() != alts.size())
+        stats->reset(alts.size());
+
+    auto r = [alts = std::move(alts), stats = std::move(stats), period](S& s) {
+        ChoiceStats& st = *stats;
+        if (++st.runs % period == 0)
+            st.reorder();
+
+        // nested runs of a recursive grammar may reorder st.order while
+        // we are still trying alternatives, so work on a snapshot
+        const size_t small = 8;
+        size_t buf[small];
+        std::vector<size_t> large;
+        size_t n = st.order.size();
+        const size_t* order = buf;
+        if (n <= small) {
+            std::copy(st.order.begin(), st.order.end(), buf);
+        } else {
+            large = st.order;
+            order = large.data();
+        }
+
+        size_t pos = s.curpos();
+        for (size_t k = 0; k < n; ++k) {
+            size_t i = order[k];
+            ++st.attempts[i];
+            auto a = alts[i].parse(s);
+            if (a.first) {
+                ++st.successes[i];
+                ++st.recent[i];
+                return a;
+            }
+            s.setpos(pos); // rewind
+        }
+
+        return std::make_pair(false, T());
+    };
+    return Parser<T, S>(std::move(r));
 }
 
-inline Parser<std::string> many(const Parser<char>& v) {
-    auto p = [v](ParseStream& s) {
+template <typename S>
+inline Parser<std::string, S> many(Parser<char, S> v) {
+    auto p = [v = std::move(v)](S& s) {
         std::string r;
         while (1) {
             size_t pos = s.curpos();
             auto a = v.parse(s);
             if (!a.first) {
                 s.setpos(pos);
-                return std::make_pair(true, r);
+                return std::make_pair(true, std::move(r));
             }
 
             r.push_back(a.second);
         }
     };
-    return Parser<std::string>(p);
+    return Parser<std::string, S>(std::move(p));
 }
 
-inline Parser<std::string> some(const Parser<char>& v) {
-    auto p = [v](ParseStream& s) {
+template <typename S>
+inline Parser<std::string, S> some(Parser<char, S> v) {
+    auto p = [v = std::move(v)](S& s) {
         std::string r;
         while (1) {
             size_t pos = s.curpos();
             auto a = v.parse(s);
             if (!a.first) {
                 s.setpos(pos);
-                return std::make_pair(r.size() > 0, r);
+                return std::make_pair(r.size() > 0, std::move(r));
             }
 
             r.push_back(a.second);
         }
     };
-    return Parser<std::string>(p);
+    return Parser<std::string, S>(std::move(p));
 }
 
-template <typename T>
-inline Parser<std::vector<T>> many_v(const Parser<T>& v) {
-    auto p = [v](ParseStream& s) {
+template <typename T, typename S>
+inline Parser<std::vector<T>, S> many_v(Parser<T, S> v) {
+    auto p = [v = std::move(v)](S& s) {
         std::vector<T> r;
         while (1) {
             size_t pos = s.curpos();
             auto a = v.parse(s);
             if (!a.first) {
                 s.setpos(pos);
-                return std::make_pair(true, r);
+                return std::make_pair(true, std::move(r));
             }
 
-            r.push_back(a.second);
+            r.push_back(std::move(a.second));
         }
     };
-    return Parser<std::vector<T>>(p);
+    return Parser<std::vector<T>, S>(std::move(p));
 }
 
-template <typename T>
-inline Parser<std::vector<T>> some_v(const Parser<T>& v) {    
-    auto p = [v](ParseStream& s) {
+template <typename T, typename S>
+inline Parser<std::vector<T>, S> some_v(Parser<T, S> v) {    
+    auto p = [v = std::move(v)](S& s) {
         std::vector<T> r;
         while (1) {
             size_t pos = s.curpos();
             auto a = v.parse(s);
             if (!a.first) {
                 s.setpos(pos);
-                return std::make_pair(r.size() > 0, r);
+                return std::make_pair(r.size() > 0, std::move(r));
             }
 
-            r.push_back(a.second);
+            r.push_back(std::move(a.second));
         }
     };
-    return Parser<std::vector<T>>(p);
+    return Parser<std::vector<T>, S>(std::move(p));
 }
 
 struct Empty {};
 
-inline Parser<Empty> many_skip(const Parser<char>& v) {
-    auto p = [v](ParseStream& s) {
+template <typename T, typename S>
+inline Parser<Empty, S> many_skip(Parser<T, S> v) {
+    auto p = [v = std::move(v)](S& s) {
         while (1) {
             size_t pos = s.curpos();
             auto a = v.parse(s);
@@ -235,30 +383,228 @@ inline Parser<Empty> many_skip(const Parser<char>& v) {
             }
         }
     };
-    return Parser<Empty>(p);
+    return Parser<Empty, S>(std::move(p));
 }
 
+// Left associative chain of p separated by op, folded as it goes.
+// chainl1 :: Parser a -> Parser (a -> a -> a) -> Parser a
+template <typename T, typename S, typename F>
+inline Parser<T, S> chainl1(Parser<T, S> p, Parser<F, S> op) {
+    auto r = [p = std::move(p), op = std::move(op)](S& s) {
+        auto a = p.parse(s);
+        if (!a.first)
+            return a;
 
-inline Parser<char> item() {
-    auto p = [](ParseStream& s) {
+        while (1) {
+            size_t pos = s.curpos();
+            auto f = op.parse(s);
+            if (!f.first) {
+                s.setpos(pos);
+                break;
+            }
+            auto b = p.parse(s);
+            if (!b.first) {
+                s.setpos(pos); // op without right operand is not part of the chain
+                break;
+            }
+            a.second = f.second(std::move(a.second), std::move(b.second));
+        }
+        return a;
+    };
+    return Parser<T, S>(std::move(r));
+}
+
+// Right associative chain of p separated by op.
+// chainr1 :: Parser a -> Parser (a -> a -> a) -> Parser a
+template <typename T, typename S, typename F>
+inline Parser<T, S> chainr1(Parser<T, S> p, Parser<F, S> op) {
+    auto r = [p = std::move(p), op = std::move(op)](S& s) {
+        auto a = p.parse(s);
+        if (!a.first)
+            return a;
+
+        std::vector<T> args;
+        std::vector<F> ops;
+        args.push_back(std::move(a.second));
+        while (1) {
+            size_t pos = s.curpos();
+            auto f = op.parse(s);
+            if (!f.first) {
+                s.setpos(pos);
+                break;
+            }
+            auto b = p.parse(s);
+            if (!b.first) {
+                s.setpos(pos);
+                break;
+            }
+            ops.push_back(std::move(f.second));
+            args.push_back(std::move(b.second));
+        }
+
+        T v = std::move(args.back());
+        for (size_t i = ops.size(); i-- > 0;)
+            v = ops[i](std::move(args[i]), std::move(v));
+        return std::make_pair(true, std::move(v));
+    };
+    return Parser<T, S>(std::move(r));
+}
+
+// Operator precedence table for expression().
+// Binding powers: an infix operator binds its left operand with lbp and
+// its right operand with rbp, so rbp = lbp + 1 makes it left associative
+// and rbp = lbp right associative. A prefix operator parses its operand
+// at bp; a postfix operator applies when its bp is at least the current
+// minimum. Operators are tried in the order they were added, and the first
+// one that applies wins: an operator whose text matches but whose binding
+// power is too low, or whose operand fails to parse, is skipped and later
+// ones are tried. So "<" added before "<=" still lets "a <= b" parse, but
+// when both could apply the earlier one is taken.
+template <typename T, typename S = ParseStream>
+struct OperatorTable {
+    using Unary = std::function<T(T)>;
+    using Binary = std::function<T(T, T)>;
+
+    struct Prefix {
+        Parser<Empty, S> op;
+        int bp;
+        Unary f;
+    };
+    struct Infix {
+        Parser<Empty, S> op;
+        int lbp;
+        int rbp;
+        Binary f;
+    };
+    struct Postfix {
+        Parser<Empty, S> op;
+        int bp;
+        Unary f;
+    };
+
+    std::vector<Prefix> prefix;
+    std::vector<Infix> infix;
+    std::vector<Postfix> postfix;
+
+    OperatorTable& add_prefix(Parser<Empty, S> op, int bp, Unary f) {
+        prefix.push_back(Prefix{std::move(op), bp, std::move(f)});
+        return *this;
+    }
+    OperatorTable& add_infix(Parser<Empty, S> op, int lbp, int rbp, Binary f) {
+        infix.push_back(Infix{std::move(op), lbp, rbp, std::move(f)});
+        return *this;
+    }
+    OperatorTable& add_infixl(Parser<Empty, S> op, int bp, Binary f) {
+        return add_infix(std::move(op), bp, bp + 1, std::move(f));
+    }
+    OperatorTable& add_infixr(Parser<Empty, S> op, int bp, Binary f) {
+        return add_infix(std::move(op), bp, bp, std::move(f));
+    }
+    OperatorTable& add_postfix(Parser<Empty, S> op, int bp, Unary f) {
+        postfix.push_back(Postfix{std::move(op), bp, std::move(f)});
+        return *this;
+    }
+};
+
+// Pratt parser driven by an OperatorTable. Rewinds happen only over an
+// operator that turns out not to apply here, and an operand is parsed again
+// only when the operator before it didn't apply.
+template <typename T, typename S>
+struct PrattParser {
+    Parser<T, S> atom;
+    OperatorTable<T, S> table;
+
+    std::pair<bool, T> parse(S& s, int min_bp) const {
+        std::pair<bool, T> lhs(false, T());
+
+        size_t pos = s.curpos();
+        for (const auto& o : table.prefix) {
+            if (o.op.parse(s).first) {
+                lhs = parse(s, o.bp);
+                if (lhs.first) {
+                    lhs.second = o.f(std::move(lhs.second));
+                    break;
+                }
+            }
+            s.setpos(pos);
+        }
+
+        if (!lhs.first) {
+            lhs = atom.parse(s);
+            if (!lhs.first)
+                return lhs;
+        }
+
+        while (1) {
+            pos = s.curpos();
+            if (apply_postfix(s, lhs.second, min_bp) || apply_infix(s, lhs.second, min_bp))
+                continue;
+
+            s.setpos(pos);
+            return lhs;
+        }
+    }
+
+    bool apply_postfix(S& s, T& lhs, int min_bp) const {
+        size_t pos = s.curpos();
+        for (const auto& o : table.postfix) {
+            if (o.op.parse(s).first && o.bp >= min_bp) {
+                lhs = o.f(std::move(lhs));
+                return true;
+            }
+            s.setpos(pos);
+        }
+        s.setpos(pos);
+        return false;
+    }
+
+    bool apply_infix(S& s, T& lhs, int min_bp) const {
+        size_t pos = s.curpos();
+        for (const auto& o : table.infix) {
+            if (o.op.parse(s).first && o.lbp >= min_bp) {
+                auto rhs = parse(s, o.rbp);
+                if (rhs.first) {
+                    lhs = o.f(std::move(lhs), std::move(rhs.second));
+                    return true;
+                }
+            }
+            s.setpos(pos);
+        }
+        s.setpos(pos);
+        return false;
+    }
+};
+
+template <typename T, typename S>
+inline Parser<T, S> expression(Parser<T, S> atom, OperatorTable<T, S> table) {
+    auto pratt = std::make_shared<const PrattParser<T, S>>(PrattParser<T, S>{std::move(atom), std::move(table)});
+    auto r = [pratt](S& s) {
+        return pratt->parse(s, 0);
+    };
+    return Parser<T, S>(std::move(r));
+}
+
+template <typename S = ParseStream, typename V = typename S::value_type>
+inline Parser<V, S> item() {
+    auto p = [](S& s) {
         if (!s.empty())
             return std::make_pair(true, s.next());
 
-        return std::make_pair(false, '\0');
+        return std::make_pair(false, V());
     };
-    return Parser<char>(p);
+    return Parser<V, S>(std::move(p));
 }
 
-template <typename P>
-inline Parser<char> satisfy(P&& fp) {
-    auto a = [fp](char c) {
+template <typename S = ParseStream, typename P, typename V = typename S::value_type>
+inline Parser<V, S> satisfy(P&& fp) {
+    auto a = [fp = std::forward<P>(fp)](V c) {
         if (fp(c))
-            return unit(c);
+            return unit<V, S>(std::move(c));
         else
-            return failure<char>();
+            return failure<V, S>();
     };
 
-    return bind(item(), a);
+    return bind(item<S>(), std::move(a));
 }
 
 inline Parser<char> one_of(const char* str) {
@@ -276,7 +622,7 @@ inline Parser<char> one_of(const char* str) {
 
         return std::make_pair(false, '\0');
     };
-    return Parser<char>(p);
+    return Parser<char>(std::move(p));
 }
 
 inline bool match_string(ParseStream& s, const char* str, size_t len)
@@ -301,7 +647,7 @@ inline Parser<std::string> string(std::string str) {
         s.setpos(pos);
         return std::make_pair(false, std::string());
     };
-    return Parser<std::string>(p);
+    return Parser<std::string>(std::move(p));
 }
 
 inline Parser<Empty> cstring_skip(const char* str) {    
@@ -313,7 +659,7 @@ inline Parser<Empty> cstring_skip(const char* str) {
         s.setpos(pos);
         return std::make_pair(false, Empty());
     };
-    return Parser<Empty>(p);
+    return Parser<Empty>(std::move(p));
 }
 
 inline Parser<std::string> spaces() {
@@ -326,10 +672,10 @@ inline Parser<Empty> spaces_skip() {
 
 //do { a <- p; spaces ; return a}
 template <typename T>
-inline Parser<T> token(const Parser<T>& p) {
-    return p >>= [](T a) {
-        return spaces_skip() >>= [a = std::move(a)](Empty) {
-            return unit<T>(std::move(a));
+inline Parser<T> token(Parser<T> p) {
+    return std::move(p) >>= [](T a) {
+        return spaces_skip() >>= [a = std::move(a)](Empty) mutable {
+            return unit_once<T>(std::move(a));
         };
     };
 }
@@ -368,7 +714,7 @@ inline Parser<int> natural() {
 
 Parser<std::string> literal() {
     return some(alphanumeric()) >>= [](std::string s) {
-        return unit(s);
+        return unit_once(std::move(s));
     };
 }
 
@@ -401,8 +747,8 @@ template <typename T>
 inline Parser<T> parens(Parser<T> p) {
     return reserved_cstr("(") >>= [p = std::move(p)](Empty) {
         return p >>= [](T n) {
-            return reserved_cstr(")") >>= [n = std::move(n)](Empty) {
-                return unit(n);
+            return reserved_cstr(")") >>= [n = std::move(n)](Empty) mutable {
+                return unit_once(std::move(n));
             };
         };
     };
@@ -412,8 +758,8 @@ template <typename T>
 inline Parser<T> quoted(Parser<T> p) {
     return reserved_cstr("\"") >>= [p = std::move(p)](Empty) {
         return p >>= [](T n) {
-            return reserved_cstr("\"") >>= [n = std::move(n)](Empty) {
-                return unit(n);
+            return reserved_cstr("\"") >>= [n = std::move(n)](Empty) mutable {
+                return unit_once(std::move(n));
             };
         };
     };
@@ -0,0 +1,494 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Parsing machine
+//
+// Grammars are built at runtime from patterns mirroring the parsec.h
+// primitives (one_of, string, option, many, bind for sequencing, rule for
+// recursion) and compiled to a flat instruction program, which is run by a
+// small interpreter with its own backtrack stack, in the spirit of LPeg's
+// parsing machine. Patterns recognize input; they don't build values.
+//
+// Choice has PEG semantics, same as option(): the first alternative that
+// succeeds wins and is never retried.
+
+namespace vm {
+
+struct CharSet {
+    uint64_t bits[4] = {};
+
+    void add(uint8_t c) { bits[c >> 6] |= (uint64_t)1 << (c & 63); }
+    bool has(uint8_t c) const { return (bits[c >> 6] >> (c & 63)) & 1; }
+
+    size_t count() const {
+        size_t n = 0;
+        for (int i = 0; i < 256; ++i)
+            n += has((uint8_t)i);
+        return n;
+    }
+    uint8_t first() const {
+        int i = 0;
+        while (i < 255 && !has((uint8_t)i))
+            ++i;
+        return (uint8_t)i;
+    }
+
+    void merge(const CharSet& other) {
+        for (int i = 0; i < 4; ++i)
+            bits[i] |= other.bits[i];
+    }
+};
+
+struct Pattern {
+    enum class Kind : uint8_t {
+        Empty,
+        Set,
+        String,
+        Any,
+        Seq,
+        Choice,
+        Many,
+        Rule
+    };
+
+    Kind kind = Kind::Empty;
+    CharSet set;
+    std::string str; // literal or rule name
+    std::vector<Pattern> items;
+};
+
+inline Pattern empty() {
+    return Pattern();
+}
+
+inline Pattern any() {
+    Pattern p;
+    p.kind = Pattern::Kind::Any;
+    return p;
+}
+
+inline Pattern one_of(const char* str) {
+    Pattern p;
+    p.kind = Pattern::Kind::Set;
+    while (*str)
+        p.set.add((uint8_t)*str++);
+    return p;
+}
+
+template <typename P>
+inline Pattern satisfy(P&& fp) {
+    Pattern p;
+    p.kind = Pattern::Kind::Set;
+    for (int c = 0; c < 256; ++c) {
+        if (fp((char)c))
+            p.set.add((uint8_t)c);
+    }
+    return p;
+}
+
+inline Pattern string(std::string str) {
+    Pattern p;
+    p.kind = Pattern::Kind::String;
+    p.str = std::move(str);
+    return p;
+}
+
+inline Pattern rule(std::string name) {
+    Pattern p;
+    p.kind = Pattern::Kind::Rule;
+    p.str = std::move(name);
+    return p;
+}
+
+// sequencing, the recognizer counterpart of p >>= [](a) { return q; }
+inline Pattern bind(Pattern p, Pattern q) {
+    Pattern r;
+    r.kind = Pattern::Kind::Seq;
+    r.items.push_back(std::move(p));
+    r.items.push_back(std::move(q));
+    return r;
+}
+
+inline Pattern seq(std::initializer_list<Pattern> ps) {
+    Pattern r;
+    r.kind = Pattern::Kind::Seq;
+    r.items.assign(ps.begin(), ps.end());
+    return r;
+}
+
+inline Pattern option(Pattern p, Pattern q) {
+    Pattern r;
+    r.kind = Pattern::Kind::Choice;
+    r.items.push_back(std::move(p));
+    r.items.push_back(std::move(q));
+    return r;
+}
+
+inline Pattern operator|(Pattern p, Pattern q) {
+    return option(std::move(p), std::move(q));
+}
+
+inline Pattern many(Pattern p) {
+    Pattern r;
+    r.kind = Pattern::Kind::Many;
+    r.items.push_back(std::move(p));
+    return r;
+}
+
+inline Pattern some(Pattern p) {
+    Pattern r = p;
+    return bind(std::move(r), many(std::move(p)));
+}
+
+struct Grammar {
+    std::map<std::string, Pattern> rules;
+
+    void define(const std::string& name, Pattern p) {
+        rules[name] = std::move(p);
+    }
+};
+
+// program
+
+enum class Op : uint8_t {
+    Char,           // match c
+    Set,            // match one char from sets[arg]
+    String,         // match literals[arg]
+    Any,            // match any char
+    Span,           // consume chars while in sets[arg]
+    Choice,         // push backtrack entry resuming at arg
+    Commit,         // pop backtrack entry, jump to arg
+    PartialCommit,  // update top backtrack entry position, jump to arg
+    Call,           // push return address, jump to arg
+    Return,
+    End
+};
+
+struct Instr {
+    Op op;
+    uint8_t c;
+    uint32_t arg;
+};
+
+struct Program {
+    std::vector<Instr> code;
+    std::vector<CharSet> sets;
+    std::vector<std::string> literals;
+};
+
+// peephole pass over the pattern tree:
+//  - nested sequences and choices are flattened, empty sequence items dropped
+//  - adjacent chars and literals in a sequence are fused into one literal
+//  - adjacent char sets in a choice are merged into one set
+inline bool is_char(const Pattern& p) {
+    return (p.kind == Pattern::Kind::Set && p.set.count() == 1)
+        || (p.kind == Pattern::Kind::String && p.str.size() == 1);
+}
+
+inline bool is_set(const Pattern& p) {
+    return p.kind == Pattern::Kind::Set || is_char(p);
+}
+
+inline CharSet to_set(const Pattern& p) {
+    if (p.kind == Pattern::Kind::Set)
+        return p.set;
+
+    CharSet s;
+    s.add((uint8_t)p.str[0]);
+    return s;
+}
+
+inline std::string to_literal(const Pattern& p) {
+    if (p.kind == Pattern::Kind::String)
+        return p.str;
+
+    return std::string(1, (char)p.set.first());
+}
+
+inline Pattern optimize(Pattern p) {
+    for (auto& q : p.items)
+        q = optimize(std::move(q));
+
+    if (p.kind == Pattern::Kind::Seq) {
+        std::vector<Pattern> items;
+        for (auto& q : p.items) {
+            if (q.kind == Pattern::Kind::Empty)
+                continue;
+
+            std::vector<Pattern> sub;
+            if (q.kind == Pattern::Kind::Seq)
+                sub = std::move(q.items);
+            else
+                sub.push_back(std::move(q));
+
+            for (auto& a : sub) {
+                bool lit = (a.kind == Pattern::Kind::String || is_char(a));
+                if (lit && !items.empty()) {
+                    Pattern& b = items.back();
+                    if (b.kind == Pattern::Kind::String || is_char(b)) {
+                        b = string(to_literal(b) + to_literal(a));
+                        continue;
+                    }
+                }
+                items.push_back(std::move(a));
+            }
+        }
+
+        if (items.empty())
+            return empty();
+        if (items.size() == 1)
+            return std::move(items[0]);
+        p.items = std::move(items);
+    } else if (p.kind == Pattern::Kind::Choice) {
+        std::vector<Pattern> items;
+        for (auto& q : p.items) {
+            std::vector<Pattern> sub;
+            if (q.kind == Pattern::Kind::Choice)
+                sub = std::move(q.items);
+            else
+                sub.push_back(std::move(q));
+
+            for (auto& a : sub) {
+                if (is_set(a) && !items.empty() && is_set(items.back())) {
+                    Pattern m;
+                    m.kind = Pattern::Kind::Set;
+                    m.set = to_set(items.back());
+                    m.set.merge(to_set(a));
+                    items.back() = std::move(m);
+                    continue;
+                }
+                items.push_back(std::move(a));
+            }
+        }
+
+        if (items.size() == 1)
+            return std::move(items[0]);
+        p.items = std::move(items);
+    }
+
+    return p;
+}
+
+struct Compiler {
+    Program prog;
+    std::vector<std::pair<size_t, std::string>> calls;
+
+    size_t emit(Op op, uint32_t arg = 0, uint8_t c = 0) {
+        prog.code.push_back(Instr{op, c, arg});
+        return prog.code.size() - 1;
+    }
+    uint32_t here() const { return (uint32_t)prog.code.size(); }
+    void patch(size_t at) { prog.code[at].arg = here(); }
+
+    uint32_t add_set(const CharSet& s) {
+        for (size_t i = 0; i < prog.sets.size(); ++i) {
+            if (memcmp(prog.sets[i].bits, s.bits, sizeof(s.bits)) == 0)
+                return (uint32_t)i;
+        }
+        prog.sets.push_back(s);
+        return (uint32_t)prog.sets.size() - 1;
+    }
+
+    void gen(const Pattern& p) {
+        switch (p.kind) {
+        case Pattern::Kind::Empty:
+            break;
+        case Pattern::Kind::Set:
+            if (is_char(p))
+                emit(Op::Char, 0, p.set.first());
+            else
+                emit(Op::Set, add_set(p.set));
+            break;
+        case Pattern::Kind::String:
+            if (p.str.size() == 1) {
+                emit(Op::Char, 0, (uint8_t)p.str[0]);
+            } else if (!p.str.empty()) {
+                prog.literals.push_back(p.str);
+                emit(Op::String, (uint32_t)prog.literals.size() - 1);
+            }
+            break;
+        case Pattern::Kind::Any:
+            emit(Op::Any);
+            break;
+        case Pattern::Kind::Seq:
+            for (const auto& q : p.items)
+                gen(q);
+            break;
+        case Pattern::Kind::Choice: {
+            //   Choice L1; p1; Commit End; L1: Choice L2; p2; Commit End; L2: pn; End:
+            std::vector<size_t> commits;
+            for (size_t i = 0; i + 1 < p.items.size(); ++i) {
+                size_t choice = emit(Op::Choice);
+                gen(p.items[i]);
+                commits.push_back(emit(Op::Commit));
+                patch(choice);
+            }
+            gen(p.items.back());
+            for (size_t c : commits)
+                patch(c);
+            break;
+        }
+        case Pattern::Kind::Many: {
+            const Pattern& q = p.items[0];
+            if (is_set(q)) {
+                emit(Op::Span, add_set(to_set(q)));
+                break;
+            }
+            //   Choice L2; L1: p; PartialCommit L1; L2:
+            size_t choice = emit(Op::Choice);
+            uint32_t loop = here();
+            gen(q);
+            emit(Op::PartialCommit, loop);
+            patch(choice);
+            break;
+        }
+        case Pattern::Kind::Rule:
+            calls.emplace_back(emit(Op::Call), p.str);
+            break;
+        }
+    }
+};
+
+// Compiles grammar rules reachable from start. Returns false on reference
+// to an undefined rule.
+inline bool compile(const Grammar& g, const std::string& start, Program& out) {
+    Compiler c;
+    c.calls.emplace_back(c.emit(Op::Call), start);
+    c.emit(Op::End);
+
+    std::map<std::string, uint32_t> addr;
+    for (size_t i = 0; i < c.calls.size(); ++i) {
+        const std::string name = c.calls[i].second;
+        if (addr.count(name))
+            continue;
+
+        auto it = g.rules.find(name);
+        if (it == g.rules.end())
+            return false;
+
+        addr[name] = c.here();
+        c.gen(optimize(it->second));
+        c.emit(Op::Return);
+    }
+
+    for (const auto& call : c.calls)
+        c.prog.code[call.first].arg = addr[call.second];
+
+    out = std::move(c.prog);
+    return true;
+}
+
+// Runs program over data. On success end is set to the number of bytes
+// matched. Rule calls nest at most max_depth deep, counting the call of the
+// start rule; deeper input (or left recursion) fails the match.
+inline bool match(const Program& prog, const uint8_t* data, size_t len, size_t& end,
+                  size_t max_depth = 1 << 16)
+{
+    const size_t ret = (size_t)-1;
+
+    struct Entry {
+        uint32_t pc;
+        size_t pos; // ret for call frames
+    };
+    std::vector<Entry> stack;
+    stack.reserve(64);
+
+    const Instr* code = prog.code.data();
+    uint32_t pc = 0;
+    size_t pos = 0;
+    size_t depth = 0; // call frames on the stack
+
+    while (1) {
+        const Instr& i = code[pc];
+        bool ok = true;
+
+        switch (i.op) {
+        case Op::Char:
+            ok = pos < len && data[pos] == i.c;
+            pos += ok;
+            ++pc;
+            break;
+        case Op::Set:
+            ok = pos < len && prog.sets[i.arg].has(data[pos]);
+            pos += ok;
+            ++pc;
+            break;
+        case Op::String: {
+            const std::string& lit = prog.literals[i.arg];
+            ok = len - pos >= lit.size() && memcmp(data + pos, lit.data(), lit.size()) == 0;
+            if (ok)
+                pos += lit.size();
+            ++pc;
+            break;
+        }
+        case Op::Any:
+            ok = pos < len;
+            pos += ok;
+            ++pc;
+            break;
+        case Op::Span: {
+            const CharSet& s = prog.sets[i.arg];
+            while (pos < len && s.has(data[pos]))
+                ++pos;
+            ++pc;
+            break;
+        }
+        case Op::Choice:
+            stack.push_back(Entry{i.arg, pos});
+            ++pc;
+            break;
+        case Op::Commit:
+            stack.pop_back();
+            pc = i.arg;
+            break;
+        case Op::PartialCommit:
+            // loop body matched empty input, leave the loop
+            if (stack.back().pos == pos) {
+                pc = stack.back().pc;
+                stack.pop_back();
+                break;
+            }
+            stack.back().pos = pos;
+            pc = i.arg;
+            break;
+        case Op::Call:
+            if (depth >= max_depth)
+                return false;
+            stack.push_back(Entry{pc + 1, ret});
+            ++depth;
+            pc = i.arg;
+            break;
+        case Op::Return:
+            pc = stack.back().pc;
+            stack.pop_back();
+            --depth;
+            break;
+        case Op::End:
+            end = pos;
+            return true;
+        }
+
+        if (ok)
+            continue;
+
+        // backtrack to the most recent choice
+        while (!stack.empty() && stack.back().pos == ret) {
+            stack.pop_back();
+            --depth;
+        }
+        if (stack.empty())
+            return false;
+
+        pc = stack.back().pc;
+        pos = stack.back().pos;
+        stack.pop_back();
+    }
+}
+
+} // namespace vm
@@ -0,0 +1,137 @@
+// Checks chainl1, chainr1 and expression() on a small integer arithmetic
+// grammar: precedence, associativity, prefix and postfix operators, table
+// order between operators sharing a prefix, and trailing operators that
+// are left unconsumed.
+
+#include <cstdio>
+#include <cstring>
+
+#include "parsec.h"
+
+static size_t failures = 0;
+
+static ParseStream stream(const char* text)
+{
+    return ParseStream(std::vector<uint8_t>(text, text + strlen(text)));
+}
+
+// parses text with p, expecting value and the parser to stop at rest
+static void check(const Parser<int>& p, const char* text, int value, const char* rest = "")
+{
+    ParseStream s = stream(text);
+    auto r = p.parse(s);
+    size_t end = strlen(text) - strlen(rest);
+    if (r.first && r.second == value && s.curpos() == end)
+        return;
+
+    ++failures;
+    if (r.first)
+        printf("\"%s\": got %d stopping at %zu, expected %d stopping at %zu\n", text, r.second, s.curpos(), value, end);
+    else
+        printf("\"%s\": parse failed, expected %d\n", text, value);
+}
+
+static void check_fails(const Parser<int>& p, const char* text)
+{
+    ParseStream s = stream(text);
+    if (!p.parse(s).first)
+        return;
+
+    ++failures;
+    printf("\"%s\": parsed, expected failure\n", text);
+}
+
+static int power(int a, int b)
+{
+    int r = 1;
+    while (b-- > 0)
+        r *= a;
+    return r;
+}
+
+static int factorial(int n)
+{
+    return n <= 1 ? 1 : n * factorial(n - 1);
+}
+
+static Parser<int> operand()
+{
+    return token(natural());
+}
+
+static Parser<std::function<int(int, int)>> binary_op(const char* op, std::function<int(int, int)> f)
+{
+    return reserved_cstr(op) >>= [f](Empty) {
+        return unit(f);
+    };
+}
+
+static Parser<int> arithmetic()
+{
+    // built on use, like the recursive json grammar
+    Parser<int> sub([](ParseStream& s) { return arithmetic().parse(s); });
+    Parser<int> atom = operand() | parens(std::move(sub));
+
+    OperatorTable<int> table;
+    table.add_infixl(reserved_cstr("<"), 10, [](int a, int b) { return a < b; })
+         .add_infixl(reserved_cstr("<="), 10, [](int a, int b) { return a <= b; })
+         .add_infixl(reserved_cstr("+"), 20, [](int a, int b) { return a + b; })
+         .add_infixl(reserved_cstr("-"), 20, [](int a, int b) { return a - b; })
+         .add_infixl(reserved_cstr("*"), 30, [](int a, int b) { return a * b; })
+         .add_infixl(reserved_cstr("/"), 30, [](int a, int b) { return a / b; })
+         .add_prefix(reserved_cstr("-"), 40, [](int a) { return -a; })
+         .add_infixr(reserved_cstr("^"), 50, power)
+         .add_postfix(reserved_cstr("!"), 60, factorial);
+
+    return expression(std::move(atom), std::move(table));
+}
+
+int main()
+{
+    Parser<int> e = arithmetic();
+
+    // precedence and associativity
+    check(e, "1 + 2 * 3", 7);
+    check(e, "(1 + 2) * 3", 9);
+    check(e, "10 - 4 - 3", 3);
+    check(e, "100 / 10 / 5", 2);
+    check(e, "2 ^ 3 ^ 2", 512);
+    check(e, "2 * 3 ^ 2", 18);
+
+    // prefix and postfix
+    check(e, "-2 ^ 2", -4);
+    check(e, "- - 3", 3);
+    check(e, "3! + 1", 7);
+    check(e, "-3!", -6);
+    check(e, "2 * 3!", 12);
+    check(e, "(1 + 2)!", 6);
+
+    // "<" is listed before "<=" and must not cut "<=" short
+    check(e, "1 <= 1", 1);
+    check(e, "2 < 1", 0);
+    check(e, "1 + 1 <= 2", 1);
+
+    // operators without an operand are left unconsumed
+    check(e, "1 +", 1, "+");
+    check(e, "1 + 2 *", 3, "*");
+    check(e, "2 ^", 2, "^");
+    check(e, "(1 + 2) )", 3, ")");
+    check_fails(e, "-");
+    check_fails(e, "* 2");
+
+    // chains
+    Parser<int> left = chainl1(operand(), binary_op("-", [](int a, int b) { return a - b; }));
+    check(left, "10 - 4 - 3", 3);
+    check(left, "10 - 4 -", 6, "-");
+
+    Parser<int> right = chainr1(operand(), binary_op("^", power));
+    check(right, "2 ^ 3 ^ 2", 512);
+    check(right, "2 ^ 3 ^", 8, "^");
+
+    // a parser built once is run many times
+    for (int i = 0; i < 3; ++i)
+        check(e, "1 + 2 * 3", 7);
+
+    printf("expr_check: %zu failures\n", failures);
+    return failures ? 1 : 0;
+}
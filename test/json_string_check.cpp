@@ -0,0 +1,90 @@
+// Differential check of json_string_decode(): the SSE2 build of
+// json_string.h against the scalar one, on random strings built from UTF-8
+// fragments and on every 3 byte value placed across a 16 byte block end.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "json_string.h"
+
+#if !defined(__SSE2__)
+#error "json_string_check compares the SSE2 decoder against the scalar one"
+#endif
+
+bool json_string_decode_scalar(const uint8_t*& p, const uint8_t* end, std::string* out);
+
+static size_t failures = 0;
+
+static void check(const std::string& in)
+{
+    const uint8_t* data = (const uint8_t*)in.data();
+    const uint8_t* end = data + in.size();
+    const uint8_t* a = data;
+    const uint8_t* b = data;
+    std::string da, db;
+    bool ra = json_string_decode(a, end, &da);
+    bool rb = json_string_decode_scalar(b, end, &db);
+
+    const uint8_t* va = data;
+    const uint8_t* vb = data;
+    bool rva = json_string_decode(va, end, nullptr);
+    bool rvb = json_string_decode_scalar(vb, end, nullptr);
+
+    bool same = ra == rb && rva == rvb && ra == rva;
+    if (same && ra)
+        same = a == b && da == db && va == vb && a == va;
+    if (same)
+        return;
+
+    if (++failures <= 10) {
+        printf("mismatch (sse2 %d, scalar %d):", ra, rb);
+        for (uint8_t c : in)
+            printf(" %02x", c);
+        printf("\n");
+    }
+}
+
+int main()
+{
+    static const char* frags[] = {
+        "a", " ", "\"", "\\n", "\\\\", "\\u00e9", "\\ud83d\\ude00", "\\ud83d", "\x01", "\x7f",
+        "\xc3\xa9", "\xe6\x97\xa5", "\xea\xb0\x80", "\xf0\x9f\x98\x80", "\xdf\xbf", "\xef\xbf\xbf",
+        "\xe0\xa0\x80", "\xe0\x9f\xbf", "\xed\x9f\xbf", "\xed\xa0\x80",
+        "\xf0\x90\x80\x80", "\xf0\x8f\xbf\xbf", "\xf4\x8f\xbf\xbf", "\xf4\x90\x80\x80",
+        "\xc0\x80", "\xc1\xbf", "\xc2", "\xe6\x97", "\xf0\x9f", "\x80", "\xbf", "\xf5\x80\x80\x80", "\xff",
+        "abcdefghijklmnop",
+    };
+    const size_t nfrags = sizeof(frags) / sizeof(frags[0]);
+
+    srand(1);
+    for (int i = 0; i < 1000000; ++i) {
+        std::string in;
+        for (int n = rand() % 24; n > 0; --n)
+            in += frags[rand() % nfrags];
+        if (rand() % 4)
+            in += '"';
+        // whatever follows the closing quote must not matter
+        for (int n = rand() % 8; n > 0; --n)
+            in += frags[rand() % nfrags];
+        check(in);
+    }
+
+    // the last byte before a sequence is at offset 12..15 of the first block
+    for (size_t off = 12; off < 16; ++off) {
+        std::string in(40, 'a');
+        in[0] = '\xc3';
+        in[1] = '\xa9';
+        in[off + 4] = '"';
+        for (uint32_t x = 0x800000; x < 0x1000000; ++x) {
+            in[off + 1] = (char)(x >> 16);
+            in[off + 2] = (char)(x >> 8);
+            in[off + 3] = (char)x;
+            check(in);
+        }
+    }
+
+    printf("json_string_check: %zu mismatches\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,17 @@
+// json_string.h built without SSE2, for comparison in json_string_check.
+// The header is wrapped in a namespace so its inline functions don't clash
+// with the SSE2 build in the other translation unit.
+
+#include <cstdint>
+#include <string>
+
+#undef __SSE2__
+
+namespace scalar {
+#include "json_string.h"
+}
+
+bool json_string_decode_scalar(const uint8_t*& p, const uint8_t* end, std::string* out)
+{
+    return scalar::json_string_decode(p, end, out);
+}